@@ -35,11 +35,28 @@
 #ifndef libAddr_hpp
 #define libAddr_hpp
 
+// Standard includes
+#include <stdint.h>
+
 // Project defines
 #define	MAX_DELIVERY_LINE_ELEMENT_SIZE		(64)
+#define	MAX_DELIVERY_LINE_TOKENS			(2 * MAX_DELIVERY_LINE_ELEMENT_SIZE)
+#define	MAX_FULL_LINE_SIZE					(4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 16)	// The cleaned input, plus what '#', PO box and rural route forms add
+#define	MAX_FUZZY_DISTANCE					(2)
+#define	MIN_FUZZY_LENGTH					(4)
+#define	MIN_FUZZY_SUBSTITUTION_LENGTH		(6)
 
 namespace libAddr {
 
+	// Parse results stored column by column - see libAddrColumns.hpp
+	class deliveryLineColumns;
+
+	// A compiled dictionary file and a reloadable handle to one - see libAddrDictionary.hpp
+	class addressDictionary;
+	class dictionaryHandle;
+	struct s_dictionary_reader;
+	typedef struct s_dictionary_reader S_DICTIONARY_READER;
+
 	// Street type structure
 	struct s_conversion_types {
 		const char *type;			// What might be expected
@@ -48,58 +65,186 @@ namespace libAddr {
 	typedef struct s_conversion_types S_CONVERSION_TYPE;
 	int compareConversionType( const void *left, const void *right);
 
+	// Token flags
+	#define	TOKEN_NUMERIC_START				(0x01)		// Starts with a digit
+	#define	TOKEN_ALL_DIGITS				(0x02)		// Nothing but digits
+	#define	TOKEN_HASH_START				(0x04)		// Starts with '#'
+	#define	TOKEN_HASH_ONLY					(0x08)		// Is just '#'
+	#define	TOKEN_REMOVED					(0x10)		// Used up - skip it
+
+	// A token within the cleaned copy of a line
+	struct s_token {
+		uint16_t offset;											// Start within copyValue
+		uint16_t length;											// Bytes in the token
+		uint16_t flags;												// TOKEN_ flags
+	};
+	typedef struct s_token S_TOKEN;
+
+	// Scratch space used while parsing a line
+	struct s_parse_scratch {
+		char copyValue [4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];	// Cleaned copy of the input
+		S_TOKEN tokens [MAX_DELIVERY_LINE_TOKENS];					// Tokens within copyValue
+		size_t nTokens;												// Tokens in use
+		uint64_t digitBits [(4 * MAX_DELIVERY_LINE_ELEMENT_SIZE) / 64 + 1];	// Digits within copyValue
+		const addressDictionary *pDictionary;						// Tables to parse with - null for the built in ones
+		int maxEditDistance;										// Misspelled types corrected within this - 0 for exact only
+	};
+	typedef struct s_parse_scratch S_PARSE_SCRATCH;
+
+	// The components of a delivery line
+	enum e_line_component {
+		LC_STREET_NUMBER = 0,
+		LC_PRE_DIRECTIONAL,
+		LC_STREET_NAME,
+		LC_STREET_TYPE,
+		LC_POST_DIRECTIONAL,
+		LC_UNIT_TYPE,
+		LC_UNIT_NUMBER,
+		LC_PO_BOX,
+		LC_RURAL_ROUTE,
+		LC_REMAINDER,
+		LC_COUNT
+	};
+	typedef enum e_line_component E_LINE_COMPONENT;
+
+	// The engines that can find the street components - both give the same results
+	enum e_parse_engine {
+		PE_RULES = 0,				// Searches the tokens for each component in turn
+		PE_STATE_MACHINE			// Classifies each token once and runs a state table over the classes
+	};
+	typedef enum e_parse_engine E_PARSE_ENGINE;
+
+	// Parse stages, timed when the library is built with LIBADDR_INSTRUMENT
+	enum e_parse_stage {
+		PS_PREPASS = 0,				// Cleaning the copy and building the token table
+		PS_HEADER_MATCH,			// Looking for a PO box or rural route header
+		PS_TOKENIZE,				// Terminating the tokens and stepping over the header
+		PS_STREET_TYPE_SCAN,		// Finding the street type - the state machine finds the units here too
+		PS_UNIT_SCAN,				// Finding a unit left or right of the street type
+		PS_ASSEMBLY,				// Filling in the components and the remainder
+		PS_COUNT
+	};
+	typedef enum e_parse_stage E_PARSE_STAGE;
+
+	// Paths a line can take, counted when the library is built with LIBADDR_INSTRUMENT
+	enum e_parse_branch {
+		PB_PO_BOX = 0,
+		PB_RURAL_ROUTE,
+		PB_STREET_TYPE,				// A street type was found
+		PB_UNIT_BEFORE_STREET,
+		PB_UNIT_AFTER_STREET,
+		PB_NUMBERED_HIGHWAY,		// A numbered street folded back into the name
+		PB_REMAINDER,				// No street type - everything went to the remainder
+		PB_COUNT
+	};
+	typedef enum e_parse_branch E_PARSE_BRANCH;
+
+	// Parse statistics, summed over every thread
+	struct s_parse_statistics {
+		uint64_t lines;								// Lines parsed
+		uint64_t branches [PB_COUNT];				// Lines taking each path
+		uint64_t stageCalls [PS_COUNT];				// Times each stage ran
+		uint64_t stageTicks [PS_COUNT];				// Time in each stage - CPU cycles where available, else nanoseconds
+	};
+	typedef struct s_parse_statistics S_PARSE_STATISTICS;
+
 	//
 	// A class to hold address compression data and utils
 	//
+	// All of the tables are immutable and the conversion tables are
+	// sorted by type, so any number of threads may construct and use
+	// this class (and deliveryLine) at once.
+	//
+	// Constructed with a dictionary, every lookup and parse goes to the
+	// dictionary's tables instead of the built in ones.
+	//
 
 	class addressCompression {
 
 	public:
 
 		// Directionals
-		static const char * KNOWN_DIRECTIONALS [];
+		static const char * const KNOWN_DIRECTIONALS [];
 
 		// PO box headers
-		static const char * KNOWN_PO_BOX_HEADERS [];
+		static const char * const KNOWN_PO_BOX_HEADERS [];
 
-		// Rural route headers
-		static const char * KNOWN_RURAL_ROUTE_HEADERS [];
+		// Rural route headers - including highway contract and military routes
+		static const char * const KNOWN_RURAL_ROUTE_HEADERS [];
+
+		// The form written for each rural route header, in the same order
+		static const char * const RURAL_ROUTE_FORMS [];
 
 		// Street types
-		static S_CONVERSION_TYPE KNOWN_STREET_TYPES [];
+		static const S_CONVERSION_TYPE KNOWN_STREET_TYPES [];
 
 		// Secondary unit designations
-		static S_CONVERSION_TYPE KNOWN_UNIT_TYPES [];
+		static const S_CONVERSION_TYPE KNOWN_UNIT_TYPES [];
 
 		// Other conversion values
-		static S_CONVERSION_TYPE OTHER_CONVERSION [];
+		static const S_CONVERSION_TYPE OTHER_CONVERSION [];
 
-		// Construction
-		// WARNING - construction is not thread safe!v
+		// Construction - with the built in tables
 		addressCompression();
 
+		// Construction - with a compiled dictionary, or the built in tables if it is null
+		addressCompression( const addressDictionary *pDictionary);
+
 		// Destruction
 		virtual ~addressCompression();
 
 		// Lookup street type - input must be capitalized
-		S_CONVERSION_TYPE * lookupStreetType( const char *streetType);
+		const S_CONVERSION_TYPE * lookupStreetType( const char *streetType) const;
+		const S_CONVERSION_TYPE * lookupStreetType( const char *streetType, const size_t typeLen) const;
 
 		// Lookup unit type - input must be capitalized
-		S_CONVERSION_TYPE * lookupUnitType( const char *unitType);
+		const S_CONVERSION_TYPE * lookupUnitType( const char *unitType) const;
+		const S_CONVERSION_TYPE * lookupUnitType( const char *unitType, const size_t typeLen) const;
+
+		// Closest type within maxDistance edits - input must be capitalized
+		// The distance is Damerau-Levenshtein with adjacent transpositions, and is held to one
+		// for words under eight letters.  The first letter must agree, and words under
+		// MIN_FUZZY_SUBSTITUTION_LENGTH letters may not have a letter changed.  Words under
+		// MIN_FUZZY_LENGTH letters, words with anything but letters, and ties between types
+		// with different preferred forms find nothing.
+		const S_CONVERSION_TYPE * lookupStreetTypeFuzzy( const char *streetType, const size_t typeLen, const int maxDistance) const;
+		const S_CONVERSION_TYPE * lookupUnitTypeFuzzy( const char *unitType, const size_t typeLen, const int maxDistance) const;
+
+		// Lookup other conversion - input must be capitalized
+		const S_CONVERSION_TYPE * lookupOtherConversion( const char *otherValue) const;
+		const S_CONVERSION_TYPE * lookupOtherConversion( const char *otherValue, const size_t valueLen) const;
+
+		// Is a cleaned token a directional?
+		bool isDirectional( const char *pText, const size_t textLen) const;
+
+		// Match the longest PO box or rural route header at the start of a cleaned line
+		// Returns LC_PO_BOX or LC_RURAL_ROUTE with the header length and index, or LC_COUNT for none
+		E_LINE_COMPONENT matchLineHeader( const char *text, size_t &headerLen, size_t &nHeader) const;
+
+		// The form written for a rural route header
+		const char * getRuralRouteForm( const size_t nHeader) const;
 
 		// Normalize a line - input will be adjusted
-		void normalizeDeliveryLine( char *addrLine, const size_t allocStringSize);
+		// Returns the length of the line; a line with no street name is left as it was
+		size_t normalizeDeliveryLine( char *addrLine, const size_t allocStringSize);
+
+		// Normalize a line into outLine, leaving the input alone
+		// Returns the length written; the output is always zero terminated
+		size_t normalizeDeliveryLine( const char *addrLine, char *outLine, const size_t outLineSize) const;
 
 	protected:
 
 		// The number of street types
-		static int nStreetTypes;
+		static const int nStreetTypes;
 
 		// The number of unit types
-		static int nUnitTypes;
+		static const int nUnitTypes;
 
 		// The number of other conversion
-		static int nOtherConversion;
+		static const int nOtherConversion;
+
+		// The dictionary in use - null for the built in tables
+		const addressDictionary *pDictionary;
 
 	};
 
@@ -117,8 +262,16 @@ namespace libAddr {
 
 	class deliveryLine {
 
+		friend class addressCompression;
+		friend class deliveryLineCache;
+		friend class deliveryLineParser;
+		friend class deliveryLineView;
+
 	public:
 
+		// Construction - empty
+		deliveryLine();
+
 		// Construction - from raw input street line
 		// Input larger than 4 * MAX_DELIVERY_LINE_ELEMENT_SIZE may be trimmed
 		deliveryLine( const char *inputLine);
@@ -129,7 +282,23 @@ namespace libAddr {
 		// Debug output dump
 		void debugDump( FILE *fOutput);
 
+		// Were parse statistics compiled in?  They are with LIBADDR_INSTRUMENT defined
+		static bool isInstrumented();
+
+		// Read the parse statistics of every thread since the last reset - all zero if not compiled in
+		static void getStatistics( S_PARSE_STATISTICS &statistics);
+
+		// Start the parse statistics over
+		static void resetStatistics();
+
+		// Statistics output dump
+		static void statisticsDump( FILE *fOutput);
+
 		// Return the full, clean line
+		// It is built on the first request and kept until the next parse, so
+		// one line should not be asked for it from several threads at once.
+		// A dictionary whose forms are much longer than the words they replace
+		// may have the line cut short at MAX_FULL_LINE_SIZE.
 		const char *getFullLine() const;
 
 		// Return the full, clean line without the street number
@@ -198,6 +367,239 @@ namespace libAddr {
 		// Remainder
 		char acRemainder[4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
 
+		// The full line - every value with a space between
+		mutable char acFullLine[MAX_FULL_LINE_SIZE + 1];
+
+		// Where the full line continues past the street number, or -1 before it is built
+		mutable int nNoNumberOffset;
+
+		// Build the full line
+		void buildFullLine() const;
+
+		// Clear every byte of the values
+		void clearAll();
+
+		// Clear the values for another parse
+		void clear();
+
+		// Join the live tokens from nFirstToken on into the remainder
+		void captureRemainder( const char *copyValue, const S_TOKEN *allTokens, const long nTokens, const long nFirstToken);
+
+		// Parse a line into the values
+		void parseLine( const char *inputLine, const size_t inputLen, S_PARSE_SCRATCH &scratch, const E_PARSE_ENGINE engine = PE_RULES);
+
+		// Parse the values from the cleaned copy and token table in scratch
+		void parseTokens( S_PARSE_SCRATCH &scratch, const E_PARSE_ENGINE engine = PE_RULES);
+
+		// Find the street components by searching the tokens - returns the first remainder token
+		long parseStreetRules( S_PARSE_SCRATCH &scratch, S_TOKEN *allTokens, const long nTokens);
+
+		// Find the street components with the state table - returns the first remainder token
+		long parseStreetMachine( S_PARSE_SCRATCH &scratch, S_TOKEN *allTokens, const long nTokens);
+
+		// Fill in the number, directionals and name around a found street type - returns the first remainder token
+		long assignStreetValues( const addressCompression &addrComp, const char *copyValue, const S_TOKEN *allTokens, const long nTokens, const long nStreetTypePos);
+
+	};
+
+	//
+	// A compact view of a parsed street line
+	//
+	// Each component is an offset and length into one packed copy of the
+	// line's text, held in a buffer owned by the caller.  The street type
+	// and unit type point straight into the static dictionaries instead.
+	// The text buffer must outlive the view.
+	//
+
+	class deliveryLineView {
+
+		friend class deliveryLineArena;
+
+	public:
+
+		// Construction - empty
+		deliveryLineView();
+
+		// Pack a parsed line into textBuffer and point this view at it
+		// The street and unit types point into pDictionary's tables, or the built in ones if it is null
+		// Returns the bytes of textBuffer used, or 0 (and an empty view) if it is too small
+		size_t assign( const deliveryLine &line, char *textBuffer, const size_t textBufferSize, const addressDictionary *pDictionary = 0x0);
+
+		// Return a component - never null
+		const char *getComponent( const E_LINE_COMPONENT component) const;
+
+		// Return the length of a component
+		size_t getComponentLength( const E_LINE_COMPONENT component) const { return( componentLength[component]); }
+
+		// Return the street number
+		const char *getStreetNumber() const { return( getComponent( LC_STREET_NUMBER)); }
+
+		// Return the pre-diretional
+		const char *getPreDirectional() const { return( getComponent( LC_PRE_DIRECTIONAL)); }
+
+		// Return the street name
+		const char *getStreetName() const { return( getComponent( LC_STREET_NAME)); }
+
+		// Return the street type
+		const char *getStreetType() const { return( getComponent( LC_STREET_TYPE)); }
+
+		// Return the post-directional
+		const char *getPostDirectional() const { return( getComponent( LC_POST_DIRECTIONAL)); }
+
+		// Return the unit type
+		const char *getUnitType() const { return( getComponent( LC_UNIT_TYPE)); }
+
+		// Return the unit number
+		const char *getUnitNumber() const { return( getComponent( LC_UNIT_NUMBER)); }
+
+		// Return the PO box
+		const char *getPOBox() const { return( getComponent( LC_PO_BOX)); }
+
+		// Return the rural route
+		const char *getRuralRoute() const { return( getComponent( LC_RURAL_ROUTE)); }
+
+		// Return the remainder
+		const char *getRemainder() const { return( getComponent( LC_REMAINDER)); }
+
+	protected:
+
+		// The packed text - owned by the caller
+		const char *pText;
+
+		// The street type - from KNOWN_STREET_TYPES
+		const char *pStreetType;
+
+		// The unit type - from KNOWN_UNIT_TYPES
+		const char *pUnitType;
+
+		// Offsets of the components within pText
+		uint16_t componentOffset [LC_COUNT];
+
+		// Lengths of the components
+		uint16_t componentLength [LC_COUNT];
+
+	};
+
+	//
+	// A reusable parser for many street lines
+	//
+	// The scratch and result storage are kept between calls, so parsing
+	// does no heap allocation.  The returned result is overwritten by the
+	// next parse.  A parser must only be used by one thread at a time.
+	//
+
+	class deliveryLineParser {
+
+		friend class deliveryLineCache;
+
+	public:
+
+		// Construction
+		deliveryLineParser();
+
+		// Destruction
+		virtual ~deliveryLineParser();
+
+		// Parse a raw input street line of inputLen bytes (need not be zero terminated)
+		// Input larger than 4 * MAX_DELIVERY_LINE_ELEMENT_SIZE may be trimmed
+		const deliveryLine & parse( const char *inputLine, const size_t inputLen);
+
+		// Return the result of the last parse
+		const deliveryLine & getResult() const { return( result); }
+
+		// Pick the engine used by later parses - PE_RULES by default
+		void setEngine( const E_PARSE_ENGINE newEngine) { engine = newEngine; }
+
+		// Pick the dictionary used by later parses - null, the default, for the built in tables
+		// The dictionary must stay open while the parser uses it
+		void setDictionary( const addressDictionary *pDictionary);
+
+		// Follow a reloadable handle - each parse uses the version current when it starts
+		// Null detaches; the handle must outlive the parser or the detach
+		void setDictionaryHandle( dictionaryHandle *pHandle);
+
+		// Let the handle delete the version last used, without waiting for the next parse
+		void releaseDictionary();
+
+		// Return the dictionary in use - with a handle, the version of the last parse
+		const addressDictionary * getDictionary() const { return( scratch.pDictionary); }
+
+		// Return the engine in use
+		E_PARSE_ENGINE getEngine() const { return( engine); }
+
+		// Correct misspelled street and unit types by up to maxDistance edits (at most
+		// MAX_FUZZY_DISTANCE) when the exact lookups find none - 0, the default, for exact only
+		// A street type is corrected only when the line has none spelled right, and a unit
+		// type only right of the street type.  Fuzzy parses always use the rules engine.
+		void setFuzzyDistance( const int maxDistance);
+
+		// Return the fuzzy distance in use
+		int getFuzzyDistance() const { return( scratch.maxEditDistance); }
+
+		// Parse a raw input street line into a compact view
+		// The view's text is packed into textBuffer; returns the bytes used, 0 if it is too small
+		size_t parse( const char *inputLine, const size_t inputLen, deliveryLineView &view, char *textBuffer, const size_t textBufferSize);
+
+		// Parse an array of nLines zero terminated lines into results[0 .. nLines - 1]
+		// Returns the number of lines parsed
+		size_t parseBatch( const char * const *inputLines, const size_t nLines, deliveryLine *results);
+
+		// Parse nLines lines from one buffer into results[0 .. nLines - 1]
+		// Line N is buffer[lineOffsets[N]] up to buffer[lineOffsets[N + 1]], so lineOffsets
+		// holds nLines + 1 entries.  A trailing newline or carriage return is ignored.
+		// Returns the number of lines parsed
+		size_t parseBatch( const char *buffer, const size_t *lineOffsets, const size_t nLines, deliveryLine *results);
+
+		// Parse an array of nLines zero terminated lines, appending a row per line to columns
+		// Returns the number of lines parsed - fewer if a column is full
+		size_t parseBatch( const char * const *inputLines, const size_t nLines, deliveryLineColumns &columns);
+
+		// Parse nLines lines from one buffer, as above, appending a row per line to columns
+		// Returns the number of lines parsed - fewer if a column is full
+		size_t parseBatch( const char *buffer, const size_t *lineOffsets, const size_t nLines, deliveryLineColumns &columns);
+
+		// Normalize an array of nLines zero terminated lines, as addressCompression::normalizeDeliveryLine
+		// Line N is written to outputLines + N * outputLineSize and its length to outputLengths[N]
+		// (outputLengths may be null).  Lines that are the same once cleaned (case, punctuation
+		// and blanks) are normalized once and the result copied to each of them.
+		// Returns the number of distinct lines normalized
+		size_t normalizeBatch( const char * const *inputLines, const size_t nLines, char *outputLines, const size_t outputLineSize, size_t *outputLengths);
+
+	protected:
+
+		// Clean a line into the scratch copy without parsing it - enterDictionary comes first
+		// Returns the length of the copy in scratch.copyValue
+		size_t prepare( const char *inputLine, const size_t inputLen);
+
+		// Parse the prepared copy into the held result
+		const deliveryLine & parsePrepared();
+
+		// Write the normalized line for a parsed result with this parser's dictionary
+		// Returns the length written to outLine, which is always terminated
+		size_t writeNormalized( const deliveryLine &dl, char *outLine, const size_t outLineSize) const;
+
+		// Pick up the current version from the handle, if there is one
+		void enterDictionary();
+
+		// Scratch space for parsing
+		S_PARSE_SCRATCH scratch;
+
+		// The last result
+		deliveryLine result;
+
+		// The engine in use
+		E_PARSE_ENGINE engine;
+
+		// The handle followed and this parser's place in it - null when there is none
+		dictionaryHandle *pDictionaryHandle;
+		S_DICTIONARY_READER *pDictionaryReader;
+
+	private:
+
+		// Not copyable - the reader belongs to one parser
+		deliveryLineParser( const deliveryLineParser &) = delete;
+		deliveryLineParser & operator=( const deliveryLineParser &) = delete;
+
 	};
 
 };
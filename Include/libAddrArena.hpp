@@ -0,0 +1,129 @@
+//
+//  libAddrArena.hpp
+//  libAddr
+//
+//  Packed bulk storage for many parse results.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+#ifndef libAddrArena_hpp
+#define libAddrArena_hpp
+
+// Standard includes
+#include <stddef.h>
+#include <stdint.h>
+
+// STL includes
+#include <vector>
+
+// Project includes
+#include <libAddr.hpp>
+
+namespace libAddr {
+
+	//
+	// Parse results for many lines, packed into one arena
+	//
+	// A deliveryLine holds every component at its full size whether it is
+	// used or not.  Here each result is a record of a bit per component
+	// with text, the offset of each such component, and the text itself,
+	// zero terminated.  A typical line takes a few dozen bytes instead of
+	// a full deliveryLine.
+	//
+	// Records are packed into large blocks that never move, so a view of
+	// a record stays valid while more are appended.  Every record is
+	// freed at once, by clear or destruction.  An arena must only be
+	// appended to by one thread at a time; once filled, any number of
+	// threads may read it.
+	//
+
+	class deliveryLineArena {
+
+	public:
+
+		// Default block size
+		static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+		// Construction - blocks are blockSize bytes, at least 4096
+		deliveryLineArena( const size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+		// Destruction - frees every record
+		virtual ~deliveryLineArena();
+
+		// Add a parsed line - returns false if there is no memory for it
+		bool append( const deliveryLine &line);
+
+		// Parse a raw input street line of inputLen bytes and add the result
+		bool append( deliveryLineParser &parser, const char *inputLine, const size_t inputLen);
+
+		// The number of records
+		size_t size() const { return( allRecords.size()); }
+
+		// Point a view at a record - returns false, and leaves the view alone, if there is no such record
+		// The view is valid until clear or destruction
+		bool get( const size_t nRecord, deliveryLineView &view) const;
+
+		// Return a component of a record - never null
+		const char * getComponent( const size_t nRecord, const E_LINE_COMPONENT component) const;
+
+		// Memory held - the blocks and the record index
+		size_t getBytesUsed() const;
+
+		// Free every record at once
+		void clear();
+
+	protected:
+
+		// Find the start of a component in a record - null if it is empty
+		const char * findComponent( const uint8_t *pRecord, const E_LINE_COMPONENT component, size_t &componentLen) const;
+
+		// The blocks, the last one being filled
+		std::vector< uint8_t *> allBlocks;
+
+		// Bytes used in the last block
+		size_t nBlockUsed;
+
+		// The size of each block
+		size_t blockSize;
+
+		// Every record, in order
+		std::vector< const uint8_t *> allRecords;
+
+	private:
+
+		// Not copyable
+		deliveryLineArena( const deliveryLineArena &) = delete;
+		deliveryLineArena & operator=( const deliveryLineArena &) = delete;
+
+	};
+
+};
+
+#endif /* libAddrArena_hpp */
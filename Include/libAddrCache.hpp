@@ -0,0 +1,139 @@
+//
+//  libAddrCache.hpp
+//  libAddr
+//
+//  A bounded, thread safe cache of parse and normalize results.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+#ifndef libAddrCache_hpp
+#define libAddrCache_hpp
+
+// Standard includes
+#include <stddef.h>
+#include <stdint.h>
+
+// Project includes
+#include <libAddr.hpp>
+
+namespace libAddr {
+
+	// Cache counters
+	struct s_cache_statistics {
+		uint64_t hits;					// Lookups answered from the cache
+		uint64_t misses;				// Lookups that had to parse
+		uint64_t insertions;			// Results added
+		uint64_t evictions;				// Results dropped to stay under the cap
+		uint64_t entries;				// Results held now
+		uint64_t bytesUsed;				// Memory held now, including the index
+		uint64_t bytesLimit;			// The memory cap
+	};
+	typedef struct s_cache_statistics S_CACHE_STATISTICS;
+
+	// One shard of the cache - defined with the implementation
+	struct s_cache_shard;
+	typedef struct s_cache_shard S_CACHE_SHARD;
+
+	//
+	// A cache of parse and normalize results
+	//
+	// Results are keyed by the cleaned copy of a line made by the
+	// parser's first pass (upper cased, punctuation dropped, blanks
+	// collapsed), so "123 Main St." and "123  MAIN ST" share an entry.
+	// A hit copies the stored result out without tokenizing the line
+	// or looking anything up in the dictionaries.
+	//
+	// The cache is split into shards, each with its own lock and its
+	// own least recently used list, so any number of threads may share
+	// one cache.  Each thread passes its own deliveryLineParser, which
+	// holds the scratch space and the returned result.  The memory cap
+	// covers the entries and the index; the least recently used entries
+	// are dropped to stay under it.
+	//
+	// Results depend on the dictionary and the fuzzy distance, so every
+	// parser sharing a cache must use the same ones, and the cache must
+	// be cleared after a new version is published to a dictionaryHandle.
+	//
+
+	class deliveryLineCache {
+
+	public:
+
+		// Default number of shards
+		static const size_t DEFAULT_SHARDS = 16;
+
+		// Construction - maxBytes caps the memory held, nShards is rounded up to a power of two
+		deliveryLineCache( const size_t maxBytes, const size_t nShards = DEFAULT_SHARDS);
+
+		// Destruction
+		virtual ~deliveryLineCache();
+
+		// Parse a raw input street line of inputLen bytes through the cache
+		// The result is held by the parser, as with deliveryLineParser::parse
+		const deliveryLine & parse( deliveryLineParser &parser, const char *inputLine, const size_t inputLen);
+
+		// Normalize a line through the cache - as addressCompression::normalizeDeliveryLine
+		// Returns the length of the line
+		size_t normalizeDeliveryLine( deliveryLineParser &parser, char *addrLine, const size_t allocStringSize);
+
+		// Read the counters
+		void getStatistics( S_CACHE_STATISTICS &statistics) const;
+
+		// Drop every entry - the counters are kept
+		void clear();
+
+	protected:
+
+		// Find a result and copy it out - returns false if it is not held
+		bool lookup( const int kind, const char *key, const size_t keyLen, const uint64_t hash, deliveryLine *dlOutput, char *addrLine, const size_t allocStringSize);
+
+		// Add a result
+		void insert( const int kind, const char *key, const size_t keyLen, const uint64_t hash, const deliveryLine *dlInput, const char *normalized, const size_t normalizedLen);
+
+		// The shards
+		S_CACHE_SHARD *allShards;
+
+		// The number of shards - a power of two
+		size_t nShards;
+
+		// The memory cap
+		size_t maxBytes;
+
+	private:
+
+		// Not copyable
+		deliveryLineCache( const deliveryLineCache &) = delete;
+		deliveryLineCache & operator=( const deliveryLineCache &) = delete;
+
+	};
+
+};
+
+#endif /* libAddrCache_hpp */
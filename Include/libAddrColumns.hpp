@@ -0,0 +1,132 @@
+//
+//  libAddrColumns.hpp
+//  libAddr
+//
+//  Parse results for many lines, stored column by column.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+#ifndef libAddrColumns_hpp
+#define libAddrColumns_hpp
+
+// Standard includes
+#include <stddef.h>
+#include <stdint.h>
+
+// STL includes
+#include <vector>
+
+// Project includes
+#include <libAddr.hpp>
+
+namespace libAddr {
+
+	// One string column, laid out as an Arrow utf8 array with no nulls
+	// Value N is data[offsets[N]] up to data[offsets[N + 1]], not zero terminated
+	struct s_string_column {
+		const int32_t *offsets;						// nValues + 1 entries, the first zero
+		const char *data;							// The values, back to back
+		size_t nValues;
+	};
+	typedef struct s_string_column S_STRING_COLUMN;
+
+	//
+	// Parse results as one column per component
+	//
+	// Each component is a string column in the Arrow layout, so the
+	// buffers can be handed to a columnar store without transposing
+	// results line by line.  The directionals, street type and unit type
+	// take few distinct values, so they are dictionary encoded: the
+	// column holds an index per line into a string column of the
+	// distinct values, which always starts with the empty string.
+	//
+	// Fill with deliveryLineParser::parseBatch or append.  Pointers from
+	// the getters are valid until the next append or clear.  A set of
+	// columns must only be filled by one thread at a time.
+	//
+
+	class deliveryLineColumns {
+
+	public:
+
+		// Construction - empty
+		deliveryLineColumns();
+
+		// Destruction
+		virtual ~deliveryLineColumns();
+
+		// Is a component dictionary encoded?
+		static bool isDictionaryEncoded( const E_LINE_COMPONENT component) {
+			return( (LC_PRE_DIRECTIONAL == component) || (LC_STREET_TYPE == component) || (LC_POST_DIRECTIONAL == component) || (LC_UNIT_TYPE == component));
+		}
+
+		// Add a parsed line as the next row
+		// Returns false, adding nothing, if a column would pass the 2GB Arrow offset limit
+		bool append( const deliveryLine &line);
+
+		// Make room for more rows
+		void reserve( const size_t nMoreRows);
+
+		// The number of rows
+		size_t size() const { return( nRows); }
+
+		// The strings of a component - its values, or for an encoded component, its dictionary
+		S_STRING_COLUMN getStrings( const E_LINE_COMPONENT component) const;
+
+		// The dictionary index of each row - null if the component is not encoded
+		const int32_t * getIndices( const E_LINE_COMPONENT component) const;
+
+		// Return one value and its length, whether encoded or not
+		size_t getValue( const size_t nRow, const E_LINE_COMPONENT component, const char *&pValue) const;
+
+		// Drop every row - the memory is kept for reuse
+		void clear();
+
+	protected:
+
+		// Find or add a value in an encoded component's dictionary
+		int32_t encode( const int component, const char *pValue, const size_t valueLen);
+
+		// Offsets and data of each string column
+		std::vector< int32_t> allOffsets [LC_COUNT];
+		std::vector< char> allData [LC_COUNT];
+
+		// Per row dictionary indexes, and the hash of the dictionary, for encoded components
+		std::vector< int32_t> allIndices [LC_COUNT];
+		std::vector< int32_t> allSlots [LC_COUNT];
+
+		// The number of rows
+		size_t nRows;
+
+	};
+
+};
+
+#endif /* libAddrColumns_hpp */
@@ -0,0 +1,142 @@
+//
+//  libAddrCorpus.hpp
+//  libAddr
+//
+//  A deterministic generator of synthetic delivery lines.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+#ifndef libAddrCorpus_hpp
+#define libAddrCorpus_hpp
+
+// Standard includes
+#include <stddef.h>
+#include <stdint.h>
+
+// Project includes
+#include <libAddr.hpp>
+
+namespace libAddr {
+
+	// The parse paths a generated line is built to take
+	enum e_corpus_path {
+		CP_STREET,					// 123 N Main St
+		CP_UNIT_AFTER,				// 123 Main St Apt 4
+		CP_UNIT_BEFORE,				// 123 Apt 4 Main St
+		CP_HASH_UNIT,				// 123 Main St #4
+		CP_PO_BOX,					// PO Box 123
+		CP_RURAL_ROUTE,				// RR 5 Box 332
+		CP_HIGHWAY,					// 123 State Hwy 715
+		CP_COUNT
+	};
+	typedef enum e_corpus_path E_CORPUS_PATH;
+
+	// The casing applied to a generated line
+	enum e_corpus_casing {
+		CC_UPPER,					// 123 MAIN ST
+		CC_LOWER,					// 123 main st
+		CC_TITLE,					// 123 Main St
+		CC_MIXED,					// Each word picked at random
+		CC_COUNT
+	};
+	typedef enum e_corpus_casing E_CORPUS_CASING;
+
+	// Generation options - weights are relative, any scale
+	struct s_corpus_options {
+		uint64_t seed;							// The same seed and options give the same lines
+		uint32_t pathWeight [CP_COUNT];			// How often each path is generated
+		uint32_t casingWeight [CC_COUNT];		// How often each casing is applied
+		uint32_t minLength;						// Lines are padded with extra words toward a length
+		uint32_t maxLength;						// picked evenly from minLength to maxLength
+		uint32_t punctuationPercent;			// Chance per word of stray punctuation or blanks
+	};
+	typedef struct s_corpus_options S_CORPUS_OPTIONS;
+
+	// Longest line the generator writes
+	#define	MAX_CORPUS_LINE_SIZE				(4 * MAX_DELIVERY_LINE_ELEMENT_SIZE)
+
+	//
+	// A generator of synthetic delivery lines
+	//
+	// Lines are built from the addressCompression tables, so they
+	// exercise the same street types, unit types, directionals and
+	// headers the parser knows.  The output depends only on the
+	// options: the random source is a fixed xorshift generator, so
+	// the same seed gives the same corpus on every platform.
+	//
+	// Padding never changes the path a line takes; a line whose
+	// required words are longer than the picked length is left as is.
+	//
+
+	class corpusGenerator {
+
+	public:
+
+		// Fill in the default options
+		static void defaultOptions( S_CORPUS_OPTIONS &options);
+
+		// Construction
+		corpusGenerator( const S_CORPUS_OPTIONS &options);
+
+		// Destruction
+		virtual ~corpusGenerator();
+
+		// Write the next line, zero terminated, into lineBuffer
+		// Returns the line length; lineBufferSize must exceed MAX_CORPUS_LINE_SIZE
+		size_t nextLine( char *lineBuffer, const size_t lineBufferSize);
+
+		// The path of the last line generated
+		E_CORPUS_PATH getLastPath() const { return( lastPath); }
+
+	protected:
+
+		// Next random value
+		uint64_t nextRandom();
+
+		// Random value below nLimit
+		uint32_t nextBelow( const uint32_t nLimit);
+
+		// Pick an index by weight
+		int pickWeighted( const uint32_t *weights, const int nWeights);
+
+		// The options in use
+		S_CORPUS_OPTIONS options;
+
+		// Generator state
+		uint64_t state;
+
+		// The path of the last line
+		E_CORPUS_PATH lastPath;
+
+	};
+
+};
+
+#endif /* libAddrCorpus_hpp */
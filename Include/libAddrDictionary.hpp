@@ -0,0 +1,328 @@
+//
+//  libAddrDictionary.hpp
+//  libAddr
+//
+//  Compiled dictionary files, mapped into memory and used in place.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+#ifndef libAddrDictionary_hpp
+#define libAddrDictionary_hpp
+
+// Standard includes
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// STL includes
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Project includes
+#include <libAddr.hpp>
+
+namespace libAddr {
+
+	// The tables held in a dictionary
+	enum e_dictionary_table {
+		DT_STREET_TYPES = 0,
+		DT_UNIT_TYPES,
+		DT_OTHER_CONVERSION,
+		DT_DIRECTIONALS,
+		DT_PO_BOX_HEADERS,
+		DT_RURAL_ROUTE_HEADERS,				// The preferred value is the form written for the route
+		DT_COUNT
+	};
+	typedef enum e_dictionary_table E_DICTIONARY_TABLE;
+
+	// File identification
+	#define	DICTIONARY_MAGIC				"LIBADDR"				// Eight bytes with the terminator
+	#define	DICTIONARY_VERSION				(1)
+
+	// Marks a hash slot with no entry
+	#define	DICTIONARY_EMPTY_SLOT			(0xFFFFFFFF)
+
+	// Character classes in the header automaton - A to Z, a blank, anything else
+	#define	DICTIONARY_HEADER_CLASSES		(28)
+
+	// One entry - both values are zero terminated strings in the string pool
+	struct s_dictionary_entry {
+		uint32_t typeOffset;							// What might be expected
+		uint32_t preftypeOffset;						// The value preferred by the USPS
+	};
+	typedef struct s_dictionary_entry S_DICTIONARY_ENTRY;
+
+	// One table and its hash index
+	struct s_dictionary_table {
+		uint32_t entryOffset;							// S_DICTIONARY_ENTRY [nEntries]
+		uint32_t nEntries;
+		uint32_t slotOffset;							// uint32_t [nSlots] - entry per slot, probed linearly
+		uint32_t nSlots;								// A power of two, larger than nEntries
+	};
+	typedef struct s_dictionary_table S_DICTIONARY_TABLE;
+
+	// One state of the PO box and rural route header automaton
+	struct s_dictionary_state {
+		uint16_t next [DICTIONARY_HEADER_CLASSES];		// Zero for no transition
+		uint16_t accept;								// Zero, or table << 8 | (entry + 1) for a header ending here
+		uint16_t depth;									// Characters consumed to get here
+	};
+	typedef struct s_dictionary_state S_DICTIONARY_STATE;
+
+	// The start of a file - every offset is from the start of the file
+	struct s_dictionary_header {
+		char magic [8];
+		uint32_t version;
+		uint32_t fileSize;
+		uint32_t stringOffset;							// The string pool, ending in a zero byte
+		uint32_t stringSize;
+		uint32_t stateOffset;							// S_DICTIONARY_STATE [nStates], the start state first
+		uint32_t nStates;
+		S_DICTIONARY_TABLE tables [DT_COUNT];
+	};
+	typedef struct s_dictionary_header S_DICTIONARY_HEADER;
+
+	//
+	// A compiled dictionary, mapped from a file
+	//
+	// The file holds every table the parser reads, with the hash index
+	// and the header automaton already built, so opening one maps it,
+	// checks the bounds and points straight into it; nothing is sorted,
+	// hashed or parsed.  The hash is hashDictionaryKey, so a change to
+	// that function needs a new DICTIONARY_VERSION.
+	//
+	// The source is plain text - a section name in brackets, then one
+	// entry per line, with '#' starting a comment:
+	//
+	//		[street_types]				ALLEE, ALY
+	//		[unit_types]				APARTMENT, APT
+	//		[other_conversions]			1ST, FIRST
+	//		[directionals]				NE
+	//		[po_box_headers]			P O BOX
+	//		[rural_route_headers]		HCR, HC
+	//
+	// Values are upper cased.  Street and unit types may not start with
+	// a digit, and headers may only hold letters and blanks.
+	//
+	// A dictionary is immutable once open and may be shared by any number
+	// of threads.  It must stay open while anything parsed with it is in
+	// use, as the street and unit types of a view point into it.
+	//
+
+	class addressDictionary {
+
+	public:
+
+		// Construction - nothing open
+		addressDictionary();
+
+		// Destruction - closes the file
+		virtual ~addressDictionary();
+
+		// Map a compiled dictionary file
+		// Returns false, with the reason in getError, if it can not be used
+		bool open( const char *pFileName);
+
+		// Unmap the file
+		void close();
+
+		// Is a file open?
+		bool isOpen() const { return( (const uint8_t *) 0x0 != pBase); }
+
+		// Why the last open or compile failed
+		const char * getError() const { return( acError); }
+
+		// Find a key of known length - input must be capitalized
+		const S_CONVERSION_TYPE * lookup( const E_DICTIONARY_TABLE table, const char *key, const size_t keyLen) const;
+
+		// The entries of a table
+		size_t getCount( const E_DICTIONARY_TABLE table) const { return( nEntries[table]); }
+		const S_CONVERSION_TYPE * getEntries( const E_DICTIONARY_TABLE table) const { return( allEntries[table]); }
+
+		// Match the longest PO box or rural route header at the start of a cleaned line
+		// Returns LC_PO_BOX or LC_RURAL_ROUTE with the header length and entry, or LC_COUNT for none
+		E_LINE_COMPONENT matchLineHeader( const char *text, size_t &headerLen, size_t &nHeader) const;
+
+		// Compile a text source into a dictionary file
+		// The file is written aside and renamed into place, so a reader never sees half of it
+		bool compile( FILE *fSource, const char *pOutputFile);
+
+		// Write the built in tables as a text source
+		static bool writeBuiltIn( FILE *fOutput);
+
+	protected:
+
+		// Fail with a reason
+		bool fail( const char *pFormat, ...);
+
+		// The mapping
+		const uint8_t *pBase;
+		size_t mapSize;
+
+		// The file header, within the mapping
+		const S_DICTIONARY_HEADER *pHeader;
+
+		// The header automaton, within the mapping
+		const S_DICTIONARY_STATE *allStates;
+
+		// The hash slots of each table, within the mapping
+		const uint32_t *allSlots [DT_COUNT];
+
+		// The entries of each table, pointing into the string pool
+		S_CONVERSION_TYPE *allEntries [DT_COUNT];
+		size_t nEntries [DT_COUNT];
+
+		// The last failure
+		char acError [256];
+
+	private:
+
+		// Not copyable
+		addressDictionary( const addressDictionary &) = delete;
+		addressDictionary & operator=( const addressDictionary &) = delete;
+
+	};
+
+	// Marks a reader that holds no version
+	#define	DICTIONARY_READER_IDLE			(UINT64_MAX)
+
+	// One registered reader - on its own cache line, as only its parser writes it
+	struct alignas( 64) s_dictionary_reader {
+		std::atomic< uint64_t> epoch;					// The epoch it entered at, or DICTIONARY_READER_IDLE
+	};
+	typedef struct s_dictionary_reader S_DICTIONARY_READER;
+
+	// A replaced version, waiting for its readers to leave
+	struct s_dictionary_retired {
+		const addressDictionary *pDictionary;
+		uint64_t epoch;									// Readers that entered at this epoch or later never saw it
+	};
+	typedef struct s_dictionary_retired S_DICTIONARY_RETIRED;
+
+	//
+	// A versioned handle to the current dictionary, for reloading it
+	// while other threads parse
+	//
+	// Readers never lock.  A parser attached with setDictionaryHandle
+	// enters at the start of each parse: it writes the current epoch to
+	// its own reader slot and loads the current version.  Publishing a
+	// version swaps the pointer and advances the epoch; the old version
+	// is deleted once every reader has entered again since, or gone idle.
+	// A parser holds the version it last used until its next parse, so
+	// the views it returned stay valid until then.
+	//
+	// Publishing, attaching and reclaiming share one lock, which parsing
+	// never takes.  Results in a deliveryLineCache are not versioned, so
+	// clear the cache after publishing.
+	//
+
+	class dictionaryHandle {
+
+	public:
+
+		// Construction - pInitial, owned by the handle, may be null for the built in tables
+		dictionaryHandle( addressDictionary *pInitial = (addressDictionary *) 0x0);
+
+		// Destruction - every version is deleted, so no reader may remain attached
+		virtual ~dictionaryHandle();
+
+		// Make a version current - the handle owns it, null for the built in tables
+		void publish( addressDictionary *pDictionary);
+
+		// Open a compiled file and make it current
+		// Returns false, with the reason in getError, if it can not be used; the current version stays
+		bool reload( const char *pFileName);
+
+		// Delete the replaced versions no reader can still see
+		// Returns the number still waiting
+		size_t reclaim();
+
+		// Wait until every replaced version is deleted
+		// The calling thread must not hold a version itself
+		void synchronize();
+
+		// The number of versions published since construction
+		uint64_t getVersion() const { return( epoch.load( std::memory_order_acquire)); }
+
+		// Why the last reload failed
+		const char * getError() const { return( acError); }
+
+		// Register a reader - for deliveryLineParser
+		S_DICTIONARY_READER * attach();
+
+		// Remove a reader, releasing what it holds
+		void detach( S_DICTIONARY_READER *pReader);
+
+		// Enter at the current version - called once per parse
+		const addressDictionary * enter( S_DICTIONARY_READER *pReader) const {
+			pReader->epoch.store( epoch.load( std::memory_order_acquire), std::memory_order_seq_cst);
+			return( pCurrent.load( std::memory_order_seq_cst));
+		}
+
+		// Release the version held, without detaching
+		void release( S_DICTIONARY_READER *pReader) const {
+			pReader->epoch.store( DICTIONARY_READER_IDLE, std::memory_order_release);
+		}
+
+	protected:
+
+		// Delete what no reader can see - the lock must be held
+		void reclaimLocked();
+
+		// The current version
+		std::atomic< const addressDictionary *> pCurrent;
+
+		// Advanced on every publish
+		std::atomic< uint64_t> epoch;
+
+		// Guards everything below
+		std::mutex writerLock;
+
+		// The registered readers
+		std::vector< S_DICTIONARY_READER *> allReaders;
+
+		// Replaced versions not yet deleted
+		std::vector< S_DICTIONARY_RETIRED> allRetired;
+
+		// The last failure
+		char acError [256];
+
+	private:
+
+		// Not copyable
+		dictionaryHandle( const dictionaryHandle &) = delete;
+		dictionaryHandle & operator=( const dictionaryHandle &) = delete;
+
+	};
+
+};
+
+#endif /* libAddrDictionary_hpp */
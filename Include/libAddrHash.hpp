@@ -0,0 +1,333 @@
+//
+//  libAddrHash.hpp
+//  libAddr
+//
+//  Compile time perfect hash indexes over the conversion tables,
+//  and a compile time prefix automaton over the line headers.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+#ifndef libAddrHash_hpp
+#define libAddrHash_hpp
+
+// Standard includes
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Project includes
+#include <libAddr.hpp>
+
+namespace libAddr {
+
+	// Length of a key - usable at compile time
+	constexpr size_t dictionaryKeyLength( const char *key) {
+		size_t keyLen = 0;
+		while( 0x0 != key[keyLen]) ++ keyLen;
+		return( keyLen);
+	}
+
+	// Compare two keys - usable at compile time
+	constexpr int compareDictionaryKeys( const char *left, const char *right) {
+		while( (0x0 != *left) && (*left == *right)) {
+			++ left;
+			++ right;
+		}
+		return( (int) (uint8_t) *left - (int) (uint8_t) *right);
+	}
+
+	// Verify a zero terminated conversion table is strictly sorted by type
+	template< size_t NENTRIES>
+	constexpr bool isConversionTableSorted( const S_CONVERSION_TYPE (&table) [NENTRIES]) {
+		for( size_t nKey = 1; (NENTRIES - 1) > nKey; ++ nKey) {
+			if( 0 <= compareDictionaryKeys( table[nKey - 1].type, table[nKey].type)) return( false);
+		}
+		return( true);
+	}
+
+	// Verify no key of a zero terminated conversion table starts with a digit
+	template< size_t NENTRIES>
+	constexpr bool isConversionTableAlphabetic( const S_CONVERSION_TYPE (&table) [NENTRIES]) {
+		for( size_t nKey = 0; (NENTRIES - 1) > nKey; ++ nKey) {
+			if( ('0' <= table[nKey].type[0]) && ('9' >= table[nKey].type[0])) return( false);
+		}
+		return( true);
+	}
+
+	// Hash a dictionary key (FNV-1a with a 64 bit finalizer)
+	constexpr uint64_t hashDictionaryKey( const char *key, const size_t keyLen) {
+		uint64_t hash = 0xCBF29CE484222325ULL;
+		for( size_t nPos = 0; keyLen > nPos; ++ nPos) {
+			hash ^= (uint8_t) key[nPos];
+			hash *= 0x100000001B3ULL;
+		}
+		hash ^= hash >> 33;
+		hash *= 0xFF51AFD7ED558CCDULL;
+		hash ^= hash >> 33;
+		return( hash);
+	}
+
+	// Number of slots for a key count - a power of two at most ~2/3 full
+	constexpr size_t perfectHashSlots( const size_t nKeys) {
+		size_t nSlots = 1;
+		while( nSlots < (nKeys + (nKeys / 2))) nSlots <<= 1;
+		return( nSlots);
+	}
+
+	// Number of displacement buckets for a key count - about four keys each
+	constexpr size_t perfectHashBuckets( const size_t nKeys) {
+		return( (nKeys + 3) / 4 + 1);
+	}
+
+	//
+	// A perfect hash index over a zero terminated conversion table
+	//
+	// Uses "hash and displace": the first level hash picks a bucket and
+	// the bucket's displacement moves its keys to a free slot.  Every
+	// lookup is one hash, one slot probe and one string compare.
+	//
+
+	template< size_t NSLOTS, size_t NBUCKETS>
+	struct perfectHashIndex {
+
+		// Marks a slot with no table entry
+		static constexpr uint16_t EMPTY_SLOT = 0xFFFF;
+
+		// Set once every key found a slot
+		bool isValid;
+
+		// Per-bucket displacement
+		uint16_t displacement [NBUCKETS];
+
+		// Table entry index per slot
+		uint16_t slot [NSLOTS];
+
+		// Bucket for a hash
+		static constexpr size_t bucketOf( const uint64_t hash) {
+			return( (size_t) ((hash >> 40) % NBUCKETS));
+		}
+
+		// Slot for a hash and displacement
+		static constexpr size_t slotOf( const uint64_t hash, const uint16_t disp) {
+			const uint32_t base = (uint32_t) hash;
+			const uint32_t step = ((uint32_t) (hash >> 20)) | 1;
+			return( (size_t) ((base + disp * step) & (NSLOTS - 1)));
+		}
+
+		// Find a key of known length
+		const S_CONVERSION_TYPE * find( const S_CONVERSION_TYPE *table, const char *key, const size_t keyLen) const {
+			const uint64_t hash = hashDictionaryKey( key, keyLen);
+			const uint16_t nEntry = slot[slotOf( hash, displacement[bucketOf( hash)])];
+			if( EMPTY_SLOT == nEntry) return( (const S_CONVERSION_TYPE *) 0x0);
+			const S_CONVERSION_TYPE *ctNode = table + nEntry;
+			if( (0x0 != strncmp( ctNode->type, key, keyLen)) || (0x0 != ctNode->type[keyLen])) return( (const S_CONVERSION_TYPE *) 0x0);
+			return( ctNode);
+		}
+
+		// Find a zero terminated key
+		const S_CONVERSION_TYPE * find( const S_CONVERSION_TYPE *table, const char *key) const {
+			return( find( table, key, strlen( key)));
+		}
+
+	};
+
+	// Build a perfect hash index at compile time
+	// The table must end with a { 0x0 , 0x0 } entry and hold no duplicate keys
+	template< size_t NSLOTS, size_t NBUCKETS, size_t NENTRIES>
+	constexpr perfectHashIndex< NSLOTS, NBUCKETS> buildPerfectHashIndex( const S_CONVERSION_TYPE (&table) [NENTRIES]) {
+
+		typedef perfectHashIndex< NSLOTS, NBUCKETS> INDEX_TYPE;
+		static_assert( 0 == (NSLOTS & (NSLOTS - 1)), "Slot count must be a power of two");
+		static_assert( NSLOTS < INDEX_TYPE::EMPTY_SLOT, "Too many slots");
+
+		INDEX_TYPE index {};
+		const size_t nKeys = NENTRIES - 1;
+		for( size_t nSlot = 0; NSLOTS > nSlot; ++ nSlot) index.slot[nSlot] = INDEX_TYPE::EMPTY_SLOT;
+
+		// Hash every key and group the keys by bucket
+		uint64_t keyHash [NENTRIES] = {};
+		size_t bucketStart [NBUCKETS + 1] = {};
+		size_t bucketKeys [NENTRIES] = {};
+		for( size_t nKey = 0; nKeys > nKey; ++ nKey) {
+			keyHash[nKey] = hashDictionaryKey( table[nKey].type, dictionaryKeyLength( table[nKey].type));
+			++ bucketStart[INDEX_TYPE::bucketOf( keyHash[nKey]) + 1];
+		}
+		for( size_t nBucket = 0; NBUCKETS > nBucket; ++ nBucket) bucketStart[nBucket + 1] += bucketStart[nBucket];
+		size_t bucketFill [NBUCKETS] = {};
+		for( size_t nKey = 0; nKeys > nKey; ++ nKey) {
+			const size_t nBucket = INDEX_TYPE::bucketOf( keyHash[nKey]);
+			bucketKeys[bucketStart[nBucket] + bucketFill[nBucket] ++] = nKey;
+		}
+
+		// Place the largest buckets first
+		size_t bucketOrder [NBUCKETS] = {};
+		for( size_t nBucket = 0; NBUCKETS > nBucket; ++ nBucket) {
+			const size_t bucketSize = bucketStart[nBucket + 1] - bucketStart[nBucket];
+			size_t nPos = nBucket;
+			for( ; (0 < nPos) && ((bucketStart[bucketOrder[nPos - 1] + 1] - bucketStart[bucketOrder[nPos - 1]]) < bucketSize); -- nPos)
+				bucketOrder[nPos] = bucketOrder[nPos - 1];
+			bucketOrder[nPos] = nBucket;
+		}
+
+		// Find a displacement for each bucket
+		for( size_t nOrder = 0; NBUCKETS > nOrder; ++ nOrder) {
+			const size_t nBucket = bucketOrder[nOrder];
+			if( bucketStart[nBucket] == bucketStart[nBucket + 1]) break;
+			bool placed = false;
+			for( uint32_t disp = 0; (! placed) && (INDEX_TYPE::EMPTY_SLOT > disp); ++ disp) {
+				size_t nPlaced = bucketStart[nBucket];
+				for( ; bucketStart[nBucket + 1] > nPlaced; ++ nPlaced) {
+					const size_t nSlot = INDEX_TYPE::slotOf( keyHash[bucketKeys[nPlaced]], (uint16_t) disp);
+					if( INDEX_TYPE::EMPTY_SLOT != index.slot[nSlot]) break;
+					index.slot[nSlot] = (uint16_t) bucketKeys[nPlaced];
+				}
+				if( bucketStart[nBucket + 1] == nPlaced) {
+					index.displacement[nBucket] = (uint16_t) disp;
+					placed = true;
+				}
+				else {
+					// Collision - back out this attempt
+					while( bucketStart[nBucket] < nPlaced) {
+						-- nPlaced;
+						index.slot[INDEX_TYPE::slotOf( keyHash[bucketKeys[nPlaced]], (uint16_t) disp)] = INDEX_TYPE::EMPTY_SLOT;
+					}
+				}
+			}
+			if( ! placed) return( index);
+		}
+
+		index.isValid = true;
+		return( index);
+
+	}
+
+	// Character classes for header matching - A to Z, a blank, then anything else
+	#define	HEADER_CLASS_COUNT				(28)
+	constexpr uint8_t headerCharClass( const char cValue) {
+		return( (('A' <= cValue) && ('Z' >= cValue)) ? (uint8_t) (cValue - 'A' + 1) : ((' ' == cValue) ? (uint8_t) 27 : (uint8_t) 0));
+	}
+
+	// Number of states for two zero terminated header lists - one per character, plus the start
+	template< size_t NFIRST, size_t NSECOND>
+	constexpr size_t prefixAutomatonStates( const char * const (&firstList) [NFIRST], const char * const (&secondList) [NSECOND]) {
+		size_t nStates = 1;
+		for( size_t nHeader = 0; (NFIRST - 1) > nHeader; ++ nHeader) nStates += dictionaryKeyLength( firstList[nHeader]);
+		for( size_t nHeader = 0; (NSECOND - 1) > nHeader; ++ nHeader) nStates += dictionaryKeyLength( secondList[nHeader]);
+		return( nStates);
+	}
+
+	//
+	// A prefix automaton over header lists
+	//
+	// Headers are only looked for at the start of a line, so this is
+	// the goto function of an Aho-Corasick automaton; the failure links
+	// are never needed.  One scan of the line finds the longest header
+	// from every list at once, however many variants there are.
+	//
+
+	template< size_t NSTATES>
+	struct prefixAutomaton {
+
+		// Marks a missing transition - the start state is never a target
+		static constexpr uint8_t NO_STATE = 0;
+
+		// Set once every header was added
+		bool isValid;
+
+		// Transitions per state and character class
+		uint8_t next [NSTATES][HEADER_CLASS_COUNT];
+
+		// Header ending at each state - zero for none, else list << 8 | (index + 1)
+		uint16_t accept [NSTATES];
+
+		// Characters consumed to reach each state
+		uint8_t depth [NSTATES];
+
+		// Match the longest header at the start of text
+		// Returns the accept value, zero for none, and sets matchLen
+		uint16_t match( const char *text, size_t &matchLen) const {
+			uint16_t bestAccept = 0;
+			matchLen = 0;
+			size_t nState = 0;
+			for( const char *pText = text; ; ++ pText) {
+				nState = next[nState][headerCharClass( *pText)];
+				if( NO_STATE == nState) break;
+				if( 0 != accept[nState]) {
+					bestAccept = accept[nState];
+					matchLen = depth[nState];
+				}
+			}
+			return( bestAccept);
+		}
+
+	};
+
+	// Build a prefix automaton at compile time
+	// Each list must end with a 0x0 entry; headers may only hold A to Z and blanks
+	template< size_t NSTATES, size_t NFIRST, size_t NSECOND>
+	constexpr prefixAutomaton< NSTATES> buildPrefixAutomaton( const char * const (&firstList) [NFIRST], const char * const (&secondList) [NSECOND]) {
+
+		typedef prefixAutomaton< NSTATES> AUTOMATON_TYPE;
+		static_assert( 256 >= NSTATES, "Too many states");
+
+		AUTOMATON_TYPE automaton {};
+		size_t nUsed = 1;
+		for( int nList = 0; 2 > nList; ++ nList) {
+			const char * const *allHeaders = (0 == nList) ? firstList : secondList;
+			const size_t nHeaders = ((0 == nList) ? NFIRST : NSECOND) - 1;
+			for( size_t nHeader = 0; nHeaders > nHeader; ++ nHeader) {
+
+				// Walk the header, adding states as needed
+				size_t nState = 0;
+				for( const char *pHeader = allHeaders[nHeader]; 0x0 != *pHeader; ++ pHeader) {
+					const uint8_t charClass = headerCharClass( *pHeader);
+					if( 0 == charClass) return( automaton);
+					if( AUTOMATON_TYPE::NO_STATE == automaton.next[nState][charClass]) {
+						automaton.depth[nUsed] = (uint8_t) (automaton.depth[nState] + 1);
+						automaton.next[nState][charClass] = (uint8_t) nUsed ++;
+					}
+					nState = automaton.next[nState][charClass];
+				}
+
+				// A repeated or empty header is a mistake
+				if( (0 == nState) || (0 != automaton.accept[nState])) return( automaton);
+				automaton.accept[nState] = (uint16_t) ((nList << 8) | (nHeader + 1));
+
+			}
+		}
+
+		automaton.isValid = true;
+		return( automaton);
+
+	}
+
+};
+
+#endif /* libAddrHash_hpp */
@@ -39,28 +39,156 @@
 #include <memory.h>
 #include <string.h>
 #include <math.h>
+#include <ctype.h>
 
 // STL includes
-#include <iterator>
 #include <vector>
+#if defined( LIBADDR_INSTRUMENT)
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#endif
+
+// Timer includes
+#if defined( LIBADDR_INSTRUMENT) && (defined( __x86_64__) || defined( __i386__))
+#include <x86intrin.h>
+#endif
+
+// SIMD includes
+#if defined( __SSE2__)
+#include <emmintrin.h>
+#endif
 
 // Project includes
 #include <libAddr.hpp>
+#include <libAddrColumns.hpp>
+#include <libAddrDictionary.hpp>
+#include <libAddrHash.hpp>
 
 namespace libAddr {
 
+#if defined( LIBADDR_INSTRUMENT)
+
+	// Statistics are kept as one flat array per thread
+	#define	STAT_LINES						(0)
+	#define	STAT_BRANCH( branch)			(1 + (branch))
+	#define	STAT_CALLS( stage)				(1 + PB_COUNT + (stage))
+	#define	STAT_TICKS( stage)				(1 + PB_COUNT + PS_COUNT + (stage))
+	#define	STAT_COUNT						(1 + PB_COUNT + 2 * PS_COUNT)
+
+	// One thread's statistics - only that thread writes them, so a load and a store is enough
+	struct s_thread_statistics {
+		std::atomic< uint64_t> allCounts [STAT_COUNT];
+		uint64_t lastTick;
+		s_thread_statistics();
+		~s_thread_statistics();
+	};
+	typedef struct s_thread_statistics S_THREAD_STATISTICS;
+
+	// Every thread's statistics, and what is left of threads that have ended
+	struct s_statistics_registry {
+		std::mutex lock;
+		std::vector< S_THREAD_STATISTICS *> allThreads;
+		uint64_t endedCounts [STAT_COUNT];
+		uint64_t baselineCounts [STAT_COUNT];
+	};
+	typedef struct s_statistics_registry S_STATISTICS_REGISTRY;
+
+	// The registry - made on first use, so it outlives every thread's statistics
+	static S_STATISTICS_REGISTRY & statisticsRegistry() {
+		static S_STATISTICS_REGISTRY registry {};
+		return( registry);
+	}
+
+	// Join the registry
+	s_thread_statistics::s_thread_statistics() {
+		for( int nStat = 0; STAT_COUNT > nStat; ++ nStat) allCounts[nStat].store( 0, std::memory_order_relaxed);
+		lastTick = 0;
+		S_STATISTICS_REGISTRY &registry = statisticsRegistry();
+		std::lock_guard< std::mutex> lock( registry.lock);
+		registry.allThreads.push_back( this);
+	}
+
+	// Leave the registry, keeping the counts
+	s_thread_statistics::~s_thread_statistics() {
+		S_STATISTICS_REGISTRY &registry = statisticsRegistry();
+		std::lock_guard< std::mutex> lock( registry.lock);
+		for( int nStat = 0; STAT_COUNT > nStat; ++ nStat) registry.endedCounts[nStat] += allCounts[nStat].load( std::memory_order_relaxed);
+		for( size_t nThread = 0; registry.allThreads.size() > nThread; ++ nThread) {
+			if( this != registry.allThreads[nThread]) continue;
+			registry.allThreads[nThread] = registry.allThreads.back();
+			registry.allThreads.pop_back();
+			break;
+		}
+	}
+
+	// This thread's statistics
+	static thread_local S_THREAD_STATISTICS threadStatistics;
+
+	// Read the clock - CPU cycles where there is a counter
+	static inline uint64_t readStatisticsTicks() {
+#if defined( __x86_64__) || defined( __i386__)
+		return( __rdtsc());
+#else
+		return( (uint64_t) std::chrono::duration_cast< std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+
+	// Add to one of this thread's counts
+	static inline void addStatistic( const int nStat, const uint64_t value) {
+		std::atomic< uint64_t> &count = threadStatistics.allCounts[nStat];
+		count.store( count.load( std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+
+	// A line starts - the clock starts with it
+	static inline void startStatistics() {
+		addStatistic( STAT_LINES, 1);
+		threadStatistics.lastTick = readStatisticsTicks();
+	}
+
+	// A stage ends - the time since the last stage ended is its own
+	static inline void lapStatistics( const int stage) {
+		const uint64_t nowTick = readStatisticsTicks();
+		addStatistic( STAT_CALLS( stage), 1);
+		addStatistic( STAT_TICKS( stage), nowTick - threadStatistics.lastTick);
+		threadStatistics.lastTick = nowTick;
+	}
+
+	// Sum every thread
+	static void sumStatistics( uint64_t *allCounts) {
+		S_STATISTICS_REGISTRY &registry = statisticsRegistry();
+		std::lock_guard< std::mutex> lock( registry.lock);
+		for( int nStat = 0; STAT_COUNT > nStat; ++ nStat) allCounts[nStat] = registry.endedCounts[nStat] - registry.baselineCounts[nStat];
+		for( const S_THREAD_STATISTICS *pThread : registry.allThreads) {
+			for( int nStat = 0; STAT_COUNT > nStat; ++ nStat) allCounts[nStat] += pThread->allCounts[nStat].load( std::memory_order_relaxed);
+		}
+	}
+
+	#define	INSTRUMENT_START()				startStatistics()
+	#define	INSTRUMENT_LAP( stage)			lapStatistics( stage)
+	#define	INSTRUMENT_COUNT( branch)		addStatistic( STAT_BRANCH( branch), 1)
+
+#else
+
+	#define	INSTRUMENT_START()				((void) 0)
+	#define	INSTRUMENT_LAP( stage)			((void) 0)
+	#define	INSTRUMENT_COUNT( branch)		((void) 0)
+
+#endif
+
 	// Compare conversion types
 	int compareConversionType( const void *left, const void *right) {
-		S_CONVERSION_TYPE *ctLeft = (S_CONVERSION_TYPE *) left;
-		S_CONVERSION_TYPE *ctRight = (S_CONVERSION_TYPE *) right;
+		const S_CONVERSION_TYPE *ctLeft = (const S_CONVERSION_TYPE *) left;
+		const S_CONVERSION_TYPE *ctRight = (const S_CONVERSION_TYPE *) right;
 		return( strcmp( ctLeft->type, ctRight->type));
 	}
 
 	// Construct an address compression
-	const char * addressCompression::KNOWN_DIRECTIONALS [] = { "E" , "N" , "S" , "W" , "NE" , "NW" , "SE" , "SW" , 0x0 };
-	const char * addressCompression::KNOWN_PO_BOX_HEADERS [] = { "POBOX " , "PO BOX " , "PO " , 0x0 };
-	const char * addressCompression::KNOWN_RURAL_ROUTE_HEADERS [] = { "RURAL ROUTE ", "RURAL RTE ", "RR ", 0x0 };
-	S_CONVERSION_TYPE addressCompression::KNOWN_STREET_TYPES [] = {
+	constexpr const char * addressCompression::KNOWN_DIRECTIONALS [] = { "E" , "N" , "S" , "W" , "NE" , "NW" , "SE" , "SW" , 0x0 };
+	constexpr const char * addressCompression::KNOWN_PO_BOX_HEADERS [] = { "POBOX " , "PO BOX " , "PO " , "P O BOX " , "POST OFFICE BOX " , 0x0 };
+	constexpr const char * addressCompression::KNOWN_RURAL_ROUTE_HEADERS [] = { "RURAL ROUTE ", "RURAL RTE ", "RR ", "HC ", "HCR ", "PSC ", "CMR ", 0x0 };
+	constexpr const char * addressCompression::RURAL_ROUTE_FORMS [] = { "RURAL ROUTE", "RURAL ROUTE", "RURAL ROUTE", "HC", "HC", "PSC", "CMR", 0x0 };
+	constexpr S_CONVERSION_TYPE addressCompression::KNOWN_STREET_TYPES [] = {
 		{ "ALLEE" , "ALY" },
 		{ "ALLEY" , "ALY" },
 		{ "ALLY" , "ALY" },
@@ -69,53 +197,53 @@ namespace libAddr {
 		{ "ANNEX" , "ANX" },
 		{ "ANNX" , "ANX" },
 		{ "ANX" , "ANX" },
-		{ "ARCADE" , "ARC" },
 		{ "ARC" , "ARC" },
-		{ "AVENUE" , "AVE" },
-		{ "AVENU" , "AVE" },
-		{ "AVEN" , "AVE" },
+		{ "ARCADE" , "ARC" },
+		{ "AV" , "AVE" },
 		{ "AVE" , "AVE" },
-		{ "AVNUE" , "AVE" },
+		{ "AVEN" , "AVE" },
+		{ "AVENU" , "AVE" },
+		{ "AVENUE" , "AVE" },
 		{ "AVN" , "AVE" },
-		{ "AV" , "AVE" },
+		{ "AVNUE" , "AVE" },
 		{ "BAYOO" , "BYU" },
 		{ "BAYOU" , "BYU" },
 		{ "BCH" , "BCH" },
 		{ "BEACH" , "BCH" },
 		{ "BEND" , "BND" },
-		{ "BGS" , "BGS" },
 		{ "BG" , "BG" },
-		{ "BLFS" , "BLFS" },
+		{ "BGS" , "BGS" },
 		{ "BLF" , "BLF" },
-		{ "BLUFFS" , "BLFS" },
-		{ "BLUFF" , "BLF" },
+		{ "BLFS" , "BLFS" },
 		{ "BLUF" , "BLF" },
+		{ "BLUFF" , "BLF" },
+		{ "BLUFFS" , "BLFS" },
 		{ "BLVD" , "BLVD" },
 		{ "BND" , "BND" },
+		{ "BOT" , "BTM" },
 		{ "BOTTM" , "BTM" },
 		{ "BOTTOM" , "BTM" },
-		{ "BOT" , "BTM" },
+		{ "BOUL" , "BLVD" },
 		{ "BOULEVARD" , "BLVD" },
 		{ "BOULV" , "BLVD" },
-		{ "BOUL" , "BLVD" },
+		{ "BR" , "BR" },
 		{ "BRANCH" , "BR" },
 		{ "BRDGE" , "BRG" },
 		{ "BRG" , "BRG" },
 		{ "BRIDGE" , "BRG" },
-		{ "BRKS" , "BRKS" },
 		{ "BRK" , "BRK" },
+		{ "BRKS" , "BRKS" },
 		{ "BRNCH" , "BR" },
-		{ "BROOKS" , "BRKS" },
 		{ "BROOK" , "BRK" },
-		{ "BR" , "BR" },
+		{ "BROOKS" , "BRKS" },
 		{ "BTM" , "BTM" },
-		{ "BURGS" , "BGS" },
 		{ "BURG" , "BG" },
-		{ "BYPASS" , "BYP" },
-		{ "BYPAS" , "BYP" },
+		{ "BURGS" , "BGS" },
+		{ "BYP" , "BYP" },
 		{ "BYPA" , "BYP" },
+		{ "BYPAS" , "BYP" },
+		{ "BYPASS" , "BYP" },
 		{ "BYPS" , "BYP" },
-		{ "BYP" , "BYP" },
 		{ "BYU" , "BYU" },
 		{ "CAMP" , "CP" },
 		{ "CANYN" , "CYN" },
@@ -123,128 +251,128 @@ namespace libAddr {
 		{ "CAPE" , "CPE" },
 		{ "CAUSEWAY" , "CSWY" },
 		{ "CAUSWA" , "CSWY" },
-		{ "CENTERS" , "CTRS" },
+		{ "CEN" , "CTR" },
+		{ "CENT" , "CTR" },
 		{ "CENTER" , "CTR" },
-		{ "CENTRE" , "CTR" },
+		{ "CENTERS" , "CTRS" },
 		{ "CENTR" , "CTR" },
-		{ "CENT" , "CTR" },
-		{ "CEN" , "CTR" },
-		{ "CIRCLES" , "CIRS" },
-		{ "CIRCLE" , "CIR" },
-		{ "CIRCL" , "CIR" },
+		{ "CENTRE" , "CTR" },
+		{ "CIR" , "CIR" },
 		{ "CIRC" , "CIR" },
+		{ "CIRCL" , "CIR" },
+		{ "CIRCLE" , "CIR" },
+		{ "CIRCLES" , "CIRS" },
 		{ "CIRS" , "CIRS" },
-		{ "CIR" , "CIR" },
 		{ "CLB" , "CLB" },
-		{ "CLFS" , "CLFS" },
 		{ "CLF" , "CLF" },
-		{ "CLIFFS" , "CLFS" },
+		{ "CLFS" , "CLFS" },
 		{ "CLIFF" , "CLF" },
+		{ "CLIFFS" , "CLFS" },
 		{ "CLUB" , "CLB" },
-		{ "CMNS" , "CMNS" },
 		{ "CMN" , "CMN" },
+		{ "CMNS" , "CMNS" },
 		{ "CMP" , "CP" },
 		{ "CNTER" , "CTR" },
 		{ "CNTR" , "CTR" },
 		{ "CNYN" , "CYN" },
-		{ "COMMONS" , "CMNS" },
 		{ "COMMON" , "CMN" },
-		{ "CORNERS" , "CORS" },
+		{ "COMMONS" , "CMNS" },
+		{ "COR" , "COR" },
 		{ "CORNER" , "COR" },
+		{ "CORNERS" , "CORS" },
 		{ "CORS" , "CORS" },
-		{ "COR" , "COR" },
 		{ "COURSE" , "CRSE" },
-		{ "COURTS" , "CTS" },
 		{ "COURT" , "CT" },
-		{ "COVES" , "CVS" },
+		{ "COURTS" , "CTS" },
 		{ "COVE" , "CV" },
-		{ "CPE" , "CPE" },
+		{ "COVES" , "CVS" },
 		{ "CP" , "CP" },
-		{ "CRCLE" , "CIR" },
+		{ "CPE" , "CPE" },
 		{ "CRCL" , "CIR" },
+		{ "CRCLE" , "CIR" },
 		{ "CREEK" , "CRK" },
+		{ "CRES" , "CRES" },
 		{ "CRESCENT" , "CRES" },
 		{ "CREST" , "CRST" },
-		{ "CRES" , "CRES" },
 		{ "CRK" , "CRK" },
 		{ "CROSSING" , "XING" },
-		{ "CROSSROADS" , "XRDS" },
 		{ "CROSSROAD" , "XRD" },
-		{ "CRSENT" , "CRES" },
+		{ "CROSSROADS" , "XRDS" },
 		{ "CRSE" , "CRSE" },
+		{ "CRSENT" , "CRES" },
 		{ "CRSNT" , "CRES" },
 		{ "CRSSNG" , "XING" },
 		{ "CRST" , "CRST" },
 		{ "CSWY" , "CSWY" },
-		{ "CTRS" , "CTRS" },
+		{ "CT" , "CT" },
 		{ "CTR" , "CTR" },
+		{ "CTRS" , "CTRS" },
 		{ "CTS" , "CTS" },
-		{ "CT" , "CT" },
-		{ "CURVE" , "CURV" },
 		{ "CURV" , "CURV" },
-		{ "CVS" , "CVS" },
+		{ "CURVE" , "CURV" },
 		{ "CV" , "CV" },
+		{ "CVS" , "CVS" },
 		{ "CYN" , "CYN" },
 		{ "DALE" , "DL" },
 		{ "DAM" , "DM" },
-		{ "DIVIDE" , "DV" },
 		{ "DIV" , "DV" },
+		{ "DIVIDE" , "DV" },
 		{ "DL" , "DL" },
 		{ "DM" , "DM" },
-		{ "DRIVES" , "DRS" },
-		{ "DRIVE" , "DR" },
+		{ "DR" , "DR" },
 		{ "DRIV" , "DR" },
+		{ "DRIVE" , "DR" },
+		{ "DRIVES" , "DRS" },
 		{ "DRS" , "DRS" },
 		{ "DRV" , "DR" },
-		{ "DR" , "DR" },
-		{ "DVD" , "DV" },
 		{ "DV" , "DV" },
-		{ "ESTATES" , "ESTS" },
+		{ "DVD" , "DV" },
+		{ "EST" , "EST" },
 		{ "ESTATE" , "EST" },
+		{ "ESTATES" , "ESTS" },
 		{ "ESTS" , "ESTS" },
-		{ "EST" , "EST" },
-		{ "EXPRESSWAY" , "EXPY" },
-		{ "EXPRESS" , "EXPY" },
+		{ "EXP" , "EXPY" },
 		{ "EXPR" , "EXPY" },
+		{ "EXPRESS" , "EXPY" },
+		{ "EXPRESSWAY" , "EXPY" },
 		{ "EXPW" , "EXPY" },
 		{ "EXPY" , "EXPY" },
-		{ "EXP" , "EXPY" },
-		{ "EXTENSIONS" , "EXTS" },
+		{ "EXT" , "EXT" },
 		{ "EXTENSION" , "EXT" },
-		{ "EXTNSN" , "EXT" },
+		{ "EXTENSIONS" , "EXTS" },
 		{ "EXTN" , "EXT" },
+		{ "EXTNSN" , "EXT" },
 		{ "EXTS" , "EXTS" },
-		{ "EXT" , "EXT" },
-		{ "FALLS" , "FLS" },
 		{ "FALL" , "FALL" },
+		{ "FALLS" , "FLS" },
 		{ "FERRY" , "FRY" },
-		{ "FIELDS" , "FLDS" },
 		{ "FIELD" , "FLD" },
-		{ "FLATS" , "FLTS" },
+		{ "FIELDS" , "FLDS" },
 		{ "FLAT" , "FLT" },
-		{ "FLDS" , "FLDS" },
+		{ "FLATS" , "FLTS" },
 		{ "FLD" , "FLD" },
+		{ "FLDS" , "FLDS" },
 		{ "FLS" , "FLS" },
-		{ "FLTS" , "FLTS" },
 		{ "FLT" , "FLT" },
-		{ "FORDS" , "FRDS" },
+		{ "FLTS" , "FLTS" },
 		{ "FORD" , "FRD" },
-		{ "FORESTS" , "FRST" },
+		{ "FORDS" , "FRDS" },
 		{ "FOREST" , "FRST" },
-		{ "FORGES" , "FRGS" },
-		{ "FORGE" , "FRG" },
+		{ "FORESTS" , "FRST" },
 		{ "FORG" , "FRG" },
-		{ "FORKS" , "FRKS" },
+		{ "FORGE" , "FRG" },
+		{ "FORGES" , "FRGS" },
 		{ "FORK" , "FRK" },
+		{ "FORKS" , "FRKS" },
 		{ "FORT" , "FT" },
-		{ "FRDS" , "FRDS" },
 		{ "FRD" , "FRD" },
+		{ "FRDS" , "FRDS" },
 		{ "FREEWAY" , "FWY" },
 		{ "FREEWY" , "FWY" },
-		{ "FRGS" , "FRGS" },
 		{ "FRG" , "FRG" },
-		{ "FRKS" , "FRKS" },
+		{ "FRGS" , "FRGS" },
 		{ "FRK" , "FRK" },
+		{ "FRKS" , "FRKS" },
 		{ "FRRY" , "FRY" },
 		{ "FRST" , "FRST" },
 		{ "FRT" , "FT" },
@@ -253,367 +381,366 @@ namespace libAddr {
 		{ "FRY" , "FRY" },
 		{ "FT" , "FT" },
 		{ "FWY" , "FWY" },
-		{ "GARDENS" , "GDNS" },
 		{ "GARDEN" , "GDN" },
+		{ "GARDENS" , "GDNS" },
 		{ "GARDN" , "GDN" },
 		{ "GATEWAY" , "GTWY" },
 		{ "GATEWY" , "GTWY" },
 		{ "GATWAY" , "GTWY" },
-		{ "GDNS" , "GDNS" },
 		{ "GDN" , "GDN" },
-		{ "GLENS" , "GLNS" },
+		{ "GDNS" , "GDNS" },
 		{ "GLEN" , "GLN" },
-		{ "GLNS" , "GLNS" },
+		{ "GLENS" , "GLNS" },
 		{ "GLN" , "GLN" },
+		{ "GLNS" , "GLNS" },
 		{ "GRDEN" , "GDN" },
-		{ "GRDNS" , "GDNS" },
 		{ "GRDN" , "GDN" },
-		{ "GREENS" , "GRNS" },
+		{ "GRDNS" , "GDNS" },
 		{ "GREEN" , "GRN" },
-		{ "GRNS" , "GRNS" },
+		{ "GREENS" , "GRNS" },
 		{ "GRN" , "GRN" },
-		{ "GROVES" , "GRVS" },
-		{ "GROVE" , "GRV" },
+		{ "GRNS" , "GRNS" },
 		{ "GROV" , "GRV" },
-		{ "GRVS" , "GRVS" },
+		{ "GROVE" , "GRV" },
+		{ "GROVES" , "GRVS" },
 		{ "GRV" , "GRV" },
+		{ "GRVS" , "GRVS" },
 		{ "GTWAY" , "GTWY" },
 		{ "GTWY" , "GTWY" },
-		{ "HARBORS" , "HBRS" },
+		{ "HARB" , "HBR" },
 		{ "HARBOR" , "HBR" },
+		{ "HARBORS" , "HBRS" },
 		{ "HARBR" , "HBR" },
-		{ "HARB" , "HBR" },
 		{ "HAVEN" , "HVN" },
-		{ "HBRS" , "HBRS" },
 		{ "HBR" , "HBR" },
+		{ "HBRS" , "HBRS" },
 		{ "HEIGHTS" , "HTS" },
 		{ "HIGHWAY" , "HWY" },
 		{ "HIGHWY" , "HWY" },
-		{ "HILLS" , "HLS" },
 		{ "HILL" , "HL" },
+		{ "HILLS" , "HLS" },
 		{ "HIWAY" , "HWY" },
 		{ "HIWY" , "HWY" },
+		{ "HL" , "HL" },
 		{ "HLLW" , "HOLW" },
 		{ "HLS" , "HLS" },
-		{ "HL" , "HL" },
-		{ "HOLLOWS" , "HOLW" },
 		{ "HOLLOW" , "HOLW" },
-		{ "HOLWS" , "HOLW" },
+		{ "HOLLOWS" , "HOLW" },
 		{ "HOLW" , "HOLW" },
+		{ "HOLWS" , "HOLW" },
 		{ "HRBOR" , "HBR" },
-		{ "HTS" , "HTS" },
 		{ "HT" , "HTS" },
+		{ "HTS" , "HTS" },
 		{ "HVN" , "HVN" },
 		{ "HWAY" , "HWY" },
 		{ "HWY" , "HWY" },
 		{ "INLET" , "INLT" },
 		{ "INLT" , "INLT" },
-		{ "ISLANDS" , "ISS" },
+		{ "IS" , "IS" },
 		{ "ISLAND" , "IS" },
-		{ "ISLES" , "ISLE" },
+		{ "ISLANDS" , "ISS" },
 		{ "ISLE" , "ISLE" },
-		{ "ISLNDS" , "ISS" },
+		{ "ISLES" , "ISLE" },
 		{ "ISLND" , "IS" },
+		{ "ISLNDS" , "ISS" },
 		{ "ISS" , "ISS" },
-		{ "IS" , "IS" },
+		{ "JCT" , "JCT" },
 		{ "JCTION" , "JCT" },
-		{ "JCTNS" , "JCTS" },
 		{ "JCTN" , "JCT" },
+		{ "JCTNS" , "JCTS" },
 		{ "JCTS" , "JCTS" },
-		{ "JCT" , "JCT" },
-		{ "JUNCTIONS" , "JCTS" },
 		{ "JUNCTION" , "JCT" },
+		{ "JUNCTIONS" , "JCTS" },
 		{ "JUNCTN" , "JCT" },
 		{ "JUNCTON" , "JCT" },
-		{ "KEYS" , "KYS" },
 		{ "KEY" , "KY" },
-		{ "KNLS" , "KNLS" },
+		{ "KEYS" , "KYS" },
 		{ "KNL" , "KNL" },
-		{ "KNOLLS" , "KNLS" },
-		{ "KNOLL" , "KNL" },
+		{ "KNLS" , "KNLS" },
 		{ "KNOL" , "KNL" },
-		{ "KYS" , "KYS" },
+		{ "KNOLL" , "KNL" },
+		{ "KNOLLS" , "KNLS" },
 		{ "KY" , "KY" },
-		{ "LAKES" , "LKS" },
+		{ "KYS" , "KYS" },
 		{ "LAKE" , "LK" },
-		{ "LANDING" , "LNDG" },
+		{ "LAKES" , "LKS" },
 		{ "LAND" , "LAND" },
+		{ "LANDING" , "LNDG" },
 		{ "LANE" , "LN" },
-		{ "LCKS" , "LCKS" },
 		{ "LCK" , "LCK" },
-		{ "LDGE" , "LDG" },
+		{ "LCKS" , "LCKS" },
 		{ "LDG" , "LDG" },
+		{ "LDGE" , "LDG" },
 		{ "LF" , "LF" },
-		{ "LGTS" , "LGTS" },
 		{ "LGT" , "LGT" },
-		{ "LIGHTS" , "LGTS" },
+		{ "LGTS" , "LGTS" },
 		{ "LIGHT" , "LGT" },
-		{ "LKS" , "LKS" },
+		{ "LIGHTS" , "LGTS" },
 		{ "LK" , "LK" },
+		{ "LKS" , "LKS" },
+		{ "LN" , "LN" },
 		{ "LNDG" , "LNDG" },
 		{ "LNDNG" , "LNDG" },
-		{ "LN" , "LN" },
 		{ "LOAF" , "LF" },
-		{ "LOCKS" , "LCKS" },
 		{ "LOCK" , "LCK" },
-		{ "LODGE" , "LDG" },
+		{ "LOCKS" , "LCKS" },
 		{ "LODG" , "LDG" },
-		{ "LOOPS" , "LOOP" },
+		{ "LODGE" , "LDG" },
 		{ "LOOP" , "LOOP" },
+		{ "LOOPS" , "LOOP" },
 		{ "MALL" , "MALL" },
-		{ "MANORS" , "MNRS" },
 		{ "MANOR" , "MNR" },
-		{ "MDWS" , "MDWS" },
-		{ "MDW" , "MDWS" },
+		{ "MANORS" , "MNRS" },
 		{ "MDW" , "MDW" },
-		{ "MEADOWS" , "MDWS" },
+		{ "MDWS" , "MDWS" },
 		{ "MEADOW" , "MDW" },
+		{ "MEADOWS" , "MDWS" },
 		{ "MEDOWS" , "MDWS" },
 		{ "MEWS" , "MEWS" },
-		{ "MILLS" , "MLS" },
 		{ "MILL" , "ML" },
+		{ "MILLS" , "MLS" },
 		{ "MISSION" , "MSN" },
 		{ "MISSN" , "MSN" },
-		{ "MLS" , "MLS" },
 		{ "ML" , "ML" },
-		{ "MNRS" , "MNRS" },
+		{ "MLS" , "MLS" },
 		{ "MNR" , "MNR" },
+		{ "MNRS" , "MNRS" },
+		{ "MNT" , "MT" },
 		{ "MNTAIN" , "MTN" },
-		{ "MNTNS" , "MTNS" },
 		{ "MNTN" , "MTN" },
-		{ "MNT" , "MT" },
+		{ "MNTNS" , "MTNS" },
 		{ "MOTORWAY" , "MTWY" },
-		{ "MOUNTAINS" , "MTNS" },
+		{ "MOUNT" , "MT" },
 		{ "MOUNTAIN" , "MTN" },
+		{ "MOUNTAINS" , "MTNS" },
 		{ "MOUNTIN" , "MTN" },
-		{ "MOUNT" , "MT" },
 		{ "MSN" , "MSN" },
 		{ "MSSN" , "MSN" },
+		{ "MT" , "MT" },
 		{ "MTIN" , "MTN" },
-		{ "MTNS" , "MTNS" },
 		{ "MTN" , "MTN" },
+		{ "MTNS" , "MTNS" },
 		{ "MTWY" , "MTWY" },
-		{ "MT" , "MT" },
 		{ "NCK" , "NCK" },
 		{ "NECK" , "NCK" },
 		{ "OPAS" , "OPAS" },
+		{ "ORCH" , "ORCH" },
 		{ "ORCHARD" , "ORCH" },
 		{ "ORCHRD" , "ORCH" },
-		{ "ORCH" , "ORCH" },
 		{ "OVAL" , "OVAL" },
 		{ "OVERPASS" , "OPAS" },
 		{ "OVL" , "OVAL" },
+		{ "PARK" , "PARK" },
 		{ "PARKS" , "PARK" },
-		{ "PARKWAYS" , "PKWY" },
 		{ "PARKWAY" , "PKWY" },
+		{ "PARKWAYS" , "PKWY" },
 		{ "PARKWY" , "PKWY" },
-		{ "PARK" , "PARK" },
-		{ "PASSAGE" , "PSGE" },
 		{ "PASS" , "PASS" },
-		{ "PATHS" , "PATH" },
+		{ "PASSAGE" , "PSGE" },
 		{ "PATH" , "PATH" },
-		{ "PIKES" , "PIKE" },
+		{ "PATHS" , "PATH" },
 		{ "PIKE" , "PIKE" },
-		{ "PINES" , "PNES" },
+		{ "PIKES" , "PIKE" },
 		{ "PINE" , "PNE" },
+		{ "PINES" , "PNES" },
 		{ "PKWAY" , "PKWY" },
-		{ "PKWYS" , "PKWY" },
 		{ "PKWY" , "PKWY" },
+		{ "PKWYS" , "PKWY" },
 		{ "PKY" , "PKWY" },
+		{ "PL" , "PL" },
 		{ "PLACE" , "PL" },
-		{ "PLAINS" , "PLNS" },
 		{ "PLAIN" , "PLN" },
+		{ "PLAINS" , "PLNS" },
 		{ "PLAZA" , "PLZ" },
-		{ "PLNS" , "PLNS" },
 		{ "PLN" , "PLN" },
-		{ "PLZA" , "PLZ" },
+		{ "PLNS" , "PLNS" },
 		{ "PLZ" , "PLZ" },
-		{ "PL" , "PL" },
-		{ "PNES" , "PNES" },
+		{ "PLZA" , "PLZ" },
 		{ "PNE" , "PNE" },
-		{ "POINTS" , "PTS" },
+		{ "PNES" , "PNES" },
 		{ "POINT" , "PT" },
-		{ "PORTS" , "PRTS" },
+		{ "POINTS" , "PTS" },
 		{ "PORT" , "PRT" },
+		{ "PORTS" , "PRTS" },
+		{ "PR" , "PR" },
 		{ "PRAIRIE" , "PR" },
 		{ "PRK" , "PARK" },
 		{ "PRR" , "PR" },
-		{ "PRTS" , "PRTS" },
 		{ "PRT" , "PRT" },
-		{ "PR" , "PR" },
+		{ "PRTS" , "PRTS" },
 		{ "PSGE" , "PSGE" },
-		{ "PTS" , "PTS" },
 		{ "PT" , "PT" },
+		{ "PTS" , "PTS" },
+		{ "RAD" , "RADL" },
 		{ "RADIAL" , "RADL" },
 		{ "RADIEL" , "RADL" },
 		{ "RADL" , "RADL" },
-		{ "RAD" , "RADL" },
 		{ "RAMP" , "RAMP" },
-		{ "RANCHES" , "RNCH" },
 		{ "RANCH" , "RNCH" },
-		{ "RAPIDS" , "RPDS" },
+		{ "RANCHES" , "RNCH" },
 		{ "RAPID" , "RPD" },
+		{ "RAPIDS" , "RPDS" },
+		{ "RD" , "RD" },
+		{ "RDG" , "RDG" },
 		{ "RDGE" , "RDG" },
 		{ "RDGS" , "RDGS" },
-		{ "RDG" , "RDG" },
 		{ "RDS" , "RDS" },
-		{ "RD" , "RD" },
 		{ "REST" , "RST" },
-		{ "RIDGES" , "RDGS" },
 		{ "RIDGE" , "RDG" },
+		{ "RIDGES" , "RDGS" },
+		{ "RIV" , "RIV" },
 		{ "RIVER" , "RIV" },
 		{ "RIVR" , "RIV" },
-		{ "RIV" , "RIV" },
-		{ "RNCHS" , "RNCH" },
 		{ "RNCH" , "RNCH" },
-		{ "ROADS" , "RDS" },
+		{ "RNCHS" , "RNCH" },
 		{ "ROAD" , "RD" },
+		{ "ROADS" , "RDS" },
 		{ "ROUTE" , "RTE" },
 		{ "ROW" , "ROW" },
-		{ "RPDS" , "RPDS" },
 		{ "RPD" , "RPD" },
+		{ "RPDS" , "RPDS" },
 		{ "RST" , "RST" },
 		{ "RTE" , "RTE" },
 		{ "RUE" , "RUE" },
 		{ "RUN" , "RUN" },
 		{ "RVR" , "RIV" },
-		{ "SHLS" , "SHLS" },
 		{ "SHL" , "SHL" },
-		{ "SHOALS" , "SHLS" },
+		{ "SHLS" , "SHLS" },
 		{ "SHOAL" , "SHL" },
-		{ "SHOARS" , "SHRS" },
+		{ "SHOALS" , "SHLS" },
 		{ "SHOAR" , "SHR" },
-		{ "SHORES" , "SHRS" },
+		{ "SHOARS" , "SHRS" },
 		{ "SHORE" , "SHR" },
-		{ "SHRS" , "SHRS" },
+		{ "SHORES" , "SHRS" },
 		{ "SHR" , "SHR" },
+		{ "SHRS" , "SHRS" },
 		{ "SKWY" , "SKWY" },
 		{ "SKYWAY" , "SKWY" },
 		{ "SMT" , "SMT" },
-		{ "SPGS" , "SPGS" },
 		{ "SPG" , "SPG" },
-		{ "SPNGS" , "SPGS" },
+		{ "SPGS" , "SPGS" },
 		{ "SPNG" , "SPG" },
-		{ "SPRINGS" , "SPGS" },
+		{ "SPNGS" , "SPGS" },
 		{ "SPRING" , "SPG" },
-		{ "SPRNGS" , "SPGS" },
+		{ "SPRINGS" , "SPGS" },
 		{ "SPRNG" , "SPG" },
-		{ "SPURS" , "SPUR" },
+		{ "SPRNGS" , "SPGS" },
 		{ "SPUR" , "SPUR" },
+		{ "SPURS" , "SPUR" },
+		{ "SQ" , "SQ" },
+		{ "SQR" , "SQ" },
 		{ "SQRE" , "SQ" },
 		{ "SQRS" , "SQS" },
-		{ "SQR" , "SQ" },
 		{ "SQS" , "SQS" },
-		{ "SQUARES" , "SQS" },
-		{ "SQUARE" , "SQ" },
 		{ "SQU" , "SQ" },
-		{ "SQ" , "SQ" },
+		{ "SQUARE" , "SQ" },
+		{ "SQUARES" , "SQS" },
+		{ "ST" , "ST" },
+		{ "STA" , "STA" },
 		{ "STATION" , "STA" },
 		{ "STATN" , "STA" },
-		{ "STA" , "STA" },
 		{ "STN" , "STA" },
-		{ "STRAVENUE" , "STRA" },
+		{ "STR" , "ST" },
+		{ "STRA" , "STRA" },
+		{ "STRAV" , "STRA" },
 		{ "STRAVEN" , "STRA" },
+		{ "STRAVENUE" , "STRA" },
 		{ "STRAVN" , "STRA" },
-		{ "STRAV" , "STRA" },
-		{ "STRA" , "STRA" },
 		{ "STREAM" , "STRM" },
-		{ "STREETS" , "STS" },
 		{ "STREET" , "ST" },
+		{ "STREETS" , "STS" },
 		{ "STREME" , "STRM" },
 		{ "STRM" , "STRM" },
 		{ "STRT" , "ST" },
-		{ "STRVNUE" , "STRA" },
 		{ "STRVN" , "STRA" },
-		{ "STR" , "ST" },
+		{ "STRVNUE" , "STRA" },
 		{ "STS" , "STS" },
-		{ "ST" , "ST" },
-		{ "SUMITT" , "SMT" },
 		{ "SUMIT" , "SMT" },
+		{ "SUMITT" , "SMT" },
 		{ "SUMMIT" , "SMT" },
-		{ "TERRACE" , "TER" },
-		{ "TERR" , "TER" },
 		{ "TER" , "TER" },
+		{ "TERR" , "TER" },
+		{ "TERRACE" , "TER" },
 		{ "THROUGHWAY" , "TRWY" },
 		{ "TPKE" , "TPKE" },
-		{ "TRACES" , "TRCE" },
 		{ "TRACE" , "TRCE" },
-		{ "TRACKS" , "TRAK" },
+		{ "TRACES" , "TRCE" },
 		{ "TRACK" , "TRAK" },
+		{ "TRACKS" , "TRAK" },
 		{ "TRAFFICWAY" , "TRFY" },
+		{ "TRAIL" , "TRL" },
 		{ "TRAILER" , "TRLR" },
 		{ "TRAILS" , "TRL" },
-		{ "TRAIL" , "TRL" },
 		{ "TRAK" , "TRAK" },
 		{ "TRCE" , "TRCE" },
 		{ "TRFY" , "TRFY" },
-		{ "TRKS" , "TRAK" },
 		{ "TRK" , "TRAK" },
-		{ "TRLRS" , "TRLR" },
+		{ "TRKS" , "TRAK" },
+		{ "TRL" , "TRL" },
 		{ "TRLR" , "TRLR" },
+		{ "TRLRS" , "TRLR" },
 		{ "TRLS" , "TRL" },
-		{ "TRL" , "TRL" },
 		{ "TRNPK" , "TPKE" },
 		{ "TRWY" , "TRWY" },
 		{ "TUNEL" , "TUNL" },
-		{ "TUNLS" , "TUNL" },
 		{ "TUNL" , "TUNL" },
-		{ "TUNNELS" , "TUNL" },
+		{ "TUNLS" , "TUNL" },
 		{ "TUNNEL" , "TUNL" },
+		{ "TUNNELS" , "TUNL" },
 		{ "TUNNL" , "TUNL" },
 		{ "TURNPIKE" , "TPKE" },
 		{ "TURNPK" , "TPKE" },
+		{ "UN" , "UN" },
 		{ "UNDERPASS" , "UPAS" },
-		{ "UNIONS" , "UNS" },
 		{ "UNION" , "UN" },
+		{ "UNIONS" , "UNS" },
 		{ "UNS" , "UNS" },
-		{ "UN" , "UN" },
 		{ "UPAS" , "UPAS" },
-		{ "VALLEYS" , "VLYS" },
 		{ "VALLEY" , "VLY" },
+		{ "VALLEYS" , "VLYS" },
 		{ "VALLY" , "VLY" },
 		{ "VDCT" , "VIA" },
+		{ "VIA" , "VIA" },
 		{ "VIADCT" , "VIA" },
 		{ "VIADUCT" , "VIA" },
-		{ "VIA" , "VIA" },
-		{ "VIEWS" , "VWS" },
 		{ "VIEW" , "VW" },
-		{ "VILLAGES" , "VLGS" },
-		{ "VILLAGE" , "VLG" },
+		{ "VIEWS" , "VWS" },
+		{ "VILL" , "VLG" },
 		{ "VILLAG" , "VLG" },
+		{ "VILLAGE" , "VLG" },
+		{ "VILLAGES" , "VLGS" },
 		{ "VILLE" , "VL" },
 		{ "VILLG" , "VLG" },
 		{ "VILLIAGE" , "VLG" },
-		{ "VILL" , "VLG" },
-		{ "VISTA" , "VIS" },
-		{ "VIST" , "VIS" },
 		{ "VIS" , "VIS" },
-		{ "VLGS" , "VLGS" },
+		{ "VIST" , "VIS" },
+		{ "VISTA" , "VIS" },
+		{ "VL" , "VL" },
 		{ "VLG" , "VLG" },
+		{ "VLGS" , "VLGS" },
 		{ "VLLY" , "VLY" },
-		{ "VLYS" , "VLYS" },
 		{ "VLY" , "VLY" },
-		{ "VL" , "VL" },
-		{ "VSTA" , "VIS" },
+		{ "VLYS" , "VLYS" },
 		{ "VST" , "VIS" },
-		{ "VWS" , "VWS" },
+		{ "VSTA" , "VIS" },
 		{ "VW" , "VW" },
-		{ "WALKS" , "WALK" },
+		{ "VWS" , "VWS" },
 		{ "WALK" , "WALK" },
+		{ "WALKS" , "WALK" },
 		{ "WALL" , "WALL" },
-		{ "WAYS" , "WAYS" },
 		{ "WAY" , "WAY" },
-		{ "WELLS" , "WLS" },
+		{ "WAYS" , "WAYS" },
 		{ "WELL" , "WL" },
-		{ "WLS" , "WLS" },
+		{ "WELLS" , "WLS" },
 		{ "WL" , "WL" },
+		{ "WLS" , "WLS" },
 		{ "WY" , "WAY" },
 		{ "XING" , "XING" },
-		{ "XRDS" , "XRDS" },
 		{ "XRD" , "XRD" },
+		{ "XRDS" , "XRDS" },
 		{ 0x0 , 0x0 }
 	};
-	S_CONVERSION_TYPE addressCompression::KNOWN_UNIT_TYPES [] = {
+	constexpr S_CONVERSION_TYPE addressCompression::KNOWN_UNIT_TYPES [] = {
 		{ "APARTMENT" , "APT" },
 		{ "APT" , "APT" },
 		{ "BASEMENT" , "BSMT" },
@@ -656,7 +783,7 @@ namespace libAddr {
 		{ "UPPR" , "UPPR" },
 		{ 0x0 , 0x0 }
 	};
-	S_CONVERSION_TYPE addressCompression::OTHER_CONVERSION [] = {
+	constexpr S_CONVERSION_TYPE addressCompression::OTHER_CONVERSION [] = {
 		{ "1ST" , "FIRST" },
 		{ "2ND" , "SECOND" },
 		{ "3RD" , "THIRD" },
@@ -668,36 +795,41 @@ namespace libAddr {
 		{ "9TH" , "NINTH" },
 		{ 0x0 , 0x0 }
 	};
-	int addressCompression::nStreetTypes = 0x0;
-	int addressCompression::nUnitTypes = 0x0;
-	int addressCompression::nOtherConversion = 0x0;
+	constexpr int N_STREET_TYPES = (int) (sizeof( addressCompression::KNOWN_STREET_TYPES) / sizeof( S_CONVERSION_TYPE)) - 1;
+	constexpr int N_UNIT_TYPES = (int) (sizeof( addressCompression::KNOWN_UNIT_TYPES) / sizeof( S_CONVERSION_TYPE)) - 1;
+	constexpr int N_OTHER_CONVERSION = (int) (sizeof( addressCompression::OTHER_CONVERSION) / sizeof( S_CONVERSION_TYPE)) - 1;
+	const int addressCompression::nStreetTypes = N_STREET_TYPES;
+	const int addressCompression::nUnitTypes = N_UNIT_TYPES;
+	const int addressCompression::nOtherConversion = N_OTHER_CONVERSION;
+
+	// Perfect hash indexes - built by the compiler
+	static constexpr auto STREET_TYPE_INDEX = buildPerfectHashIndex< perfectHashSlots( N_STREET_TYPES), perfectHashBuckets( N_STREET_TYPES)>( addressCompression::KNOWN_STREET_TYPES);
+	static constexpr auto UNIT_TYPE_INDEX = buildPerfectHashIndex< perfectHashSlots( N_UNIT_TYPES), perfectHashBuckets( N_UNIT_TYPES)>( addressCompression::KNOWN_UNIT_TYPES);
+	static constexpr auto OTHER_CONVERSION_INDEX = buildPerfectHashIndex< perfectHashSlots( N_OTHER_CONVERSION), perfectHashBuckets( N_OTHER_CONVERSION)>( addressCompression::OTHER_CONVERSION);
+	static_assert( isConversionTableSorted( addressCompression::KNOWN_STREET_TYPES), "Street types must be sorted");
+	static_assert( isConversionTableSorted( addressCompression::KNOWN_UNIT_TYPES), "Unit types must be sorted");
+	static_assert( isConversionTableSorted( addressCompression::OTHER_CONVERSION), "Other conversions must be sorted");
+	static_assert( STREET_TYPE_INDEX.isValid, "Street types must be unique");
+	static_assert( UNIT_TYPE_INDEX.isValid, "Unit types must be unique");
+	static_assert( OTHER_CONVERSION_INDEX.isValid, "Other conversions must be unique");
+	static_assert( isConversionTableAlphabetic( addressCompression::KNOWN_STREET_TYPES), "The street state machine skips numeric tokens");
+	static_assert( isConversionTableAlphabetic( addressCompression::KNOWN_UNIT_TYPES), "The street state machine skips numeric tokens");
+
+	// Line headers - PO boxes are list 0, rural routes list 1
+	#define	HEADER_LIST_PO_BOX				(0)
+	#define	HEADER_LIST_RURAL_ROUTE			(1)
+	static constexpr auto LINE_HEADER_AUTOMATON = buildPrefixAutomaton< prefixAutomatonStates( addressCompression::KNOWN_PO_BOX_HEADERS, addressCompression::KNOWN_RURAL_ROUTE_HEADERS)>(
+		addressCompression::KNOWN_PO_BOX_HEADERS, addressCompression::KNOWN_RURAL_ROUTE_HEADERS);
+	static_assert( LINE_HEADER_AUTOMATON.isValid, "Line headers must be unique and hold only letters and blanks");
+	static_assert( sizeof( addressCompression::KNOWN_RURAL_ROUTE_HEADERS) == sizeof( addressCompression::RURAL_ROUTE_FORMS), "Every rural route header needs a form");
 
 	// Construct the address compression class
-	addressCompression::addressCompression() {
-
-		// Need to count and sort street types?
-		if( 0x0 == nStreetTypes) {
-			int nST = 0;
-			while( (const char *) 0x0 != KNOWN_STREET_TYPES[nST ++].type);
-			nStreetTypes = nST - 1;
-			qsort( KNOWN_STREET_TYPES, nStreetTypes, sizeof( S_CONVERSION_TYPE), compareConversionType);
-		}
+	addressCompression::addressCompression() : pDictionary( (const addressDictionary *) 0x0) {
 
-		// Need to count unit types?
-		if( 0x0 == nUnitTypes) {
-			int nUT = 0;
-			while( (const char *) 0x0 != KNOWN_UNIT_TYPES[nUT ++].type);
-			nUnitTypes = nUT - 1;
-			qsort( KNOWN_UNIT_TYPES, nUnitTypes, sizeof( S_CONVERSION_TYPE), compareConversionType);
-		}
+	}
 
-		// Need to count other conversions?
-		if( 0x0 == nOtherConversion) {
-			int nOT = 0;
-			while( (const char *) 0x0 != OTHER_CONVERSION[nOT ++].type);
-			nOtherConversion = nOT - 1;
-			qsort( OTHER_CONVERSION, nOtherConversion, sizeof( S_CONVERSION_TYPE), compareConversionType);
-		}
+	// Construct the address compression class over a dictionary
+	addressCompression::addressCompression( const addressDictionary *pUseDictionary) : pDictionary( pUseDictionary) {
 
 	}
 
@@ -707,93 +839,492 @@ namespace libAddr {
 	}
 
 	// Lookup street type
-	S_CONVERSION_TYPE * addressCompression::lookupStreetType( const char *streetType) {
-		S_CONVERSION_TYPE key = { streetType, (const char *) 0x0 };
-		S_CONVERSION_TYPE *ctNode = (S_CONVERSION_TYPE *) bsearch( &key, KNOWN_STREET_TYPES, nStreetTypes, sizeof( S_CONVERSION_TYPE), compareConversionType);
-		return( ctNode);
+	const S_CONVERSION_TYPE * addressCompression::lookupStreetType( const char *streetType) const {
+		return( lookupStreetType( streetType, strlen( streetType)));
+	}
+
+	// Lookup street type of known length
+	const S_CONVERSION_TYPE * addressCompression::lookupStreetType( const char *streetType, const size_t typeLen) const {
+		if( (const addressDictionary *) 0x0 != pDictionary) return( pDictionary->lookup( DT_STREET_TYPES, streetType, typeLen));
+		return( STREET_TYPE_INDEX.find( KNOWN_STREET_TYPES, streetType, typeLen));
 	}
 
 	// Lookup unit type
-	S_CONVERSION_TYPE * addressCompression::lookupUnitType( const char *unitType) {
-		S_CONVERSION_TYPE key = { unitType, (const char *) 0x0 };
-		S_CONVERSION_TYPE *ctNode = (S_CONVERSION_TYPE *) bsearch( &key, KNOWN_UNIT_TYPES, nUnitTypes, sizeof( S_CONVERSION_TYPE), compareConversionType);
-		return( ctNode);
+	const S_CONVERSION_TYPE * addressCompression::lookupUnitType( const char *unitType) const {
+		return( lookupUnitType( unitType, strlen( unitType)));
 	}
 
-	void addressCompression::normalizeDeliveryLine( char *addrLine, const size_t allocStringSize) {
+	// Lookup unit type of known length
+	const S_CONVERSION_TYPE * addressCompression::lookupUnitType( const char *unitType, const size_t typeLen) const {
+		if( (const addressDictionary *) 0x0 != pDictionary) return( pDictionary->lookup( DT_UNIT_TYPES, unitType, typeLen));
+		return( UNIT_TYPE_INDEX.find( KNOWN_UNIT_TYPES, unitType, typeLen));
+	}
 
-		// Trivial?
-		if( (char *) 0x0 == addrLine) return;
-		if( 0x0 == allocStringSize) return;
-		if( 0x0 == addrLine[0]) return;
+	// A word to match against, as one bit mask per letter - bit N is set where letter N is that letter
+	struct s_fuzzy_pattern {
+		uint64_t allMasks [26];
+		uint64_t lastBit;
+		int length;
+	};
+	typedef struct s_fuzzy_pattern S_FUZZY_PATTERN;
+
+	//
+	// Edit distance from the pattern to a word, bit parallel
+	//
+	// This is Myers' column of the edit distance table held in two bit
+	// vectors, with Hyyro's term for adjacent transpositions added, so
+	// each letter of the word costs a handful of word operations however
+	// long the pattern is.  The bottom row of the table is the score,
+	// moved up or down by the last bit of each column's delta.
+	//
+	static int fuzzyDistance( const S_FUZZY_PATTERN &pattern, const char *word, const size_t wordLen) {
+		uint64_t vp = ~0ULL, vn = 0, d0 = 0, pmPrev = 0;
+		int score = pattern.length;
+		for( size_t nPos = 0; wordLen > nPos; ++ nPos) {
+			const unsigned letter = (unsigned) (word[nPos] - 'A');
+			const uint64_t pm = (26 > letter) ? pattern.allMasks[letter] : 0;
+			const uint64_t tr = (((~d0) & pm) << 1) & pmPrev;
+			d0 = (((pm & vp) + vp) ^ vp) | pm | vn | tr;
+			uint64_t hp = vn | ~(d0 | vp);
+			const uint64_t hn = vp & d0;
+			if( 0 != (hp & pattern.lastBit)) ++ score;
+			if( 0 != (hn & pattern.lastBit)) -- score;
+			hp = (hp << 1) | 1;
+			vp = (hn << 1) | ~(d0 | hp);
+			vn = hp & d0;
+			pmPrev = pm;
+		}
+		return( score);
+	}
+
+	// Are two words of the same length the same letters in another order?
+	static bool sameLetters( const char *left, const char *right, const size_t wordLen) {
+		int allCounts [26] = { 0 };
+		for( size_t nPos = 0; wordLen > nPos; ++ nPos) {
+			++ allCounts[left[nPos] - 'A'];
+			const unsigned letter = (unsigned) (right[nPos] - 'A');
+			if( 26 <= letter) return( false);
+			-- allCounts[letter];
+		}
+		for( int nLetter = 0; 26 > nLetter; ++ nLetter) if( 0 != allCounts[nLetter]) return( false);
+		return( true);
+	}
+
+	// The closest type in a table within maxDistance - null for none, or a tie between preferred forms
+	static const S_CONVERSION_TYPE * closestConversion( const S_CONVERSION_TYPE *allTypes, const size_t nTypes, const char *text, const size_t textLen, const int maxDistance) {
+
+		// Short words are one edit from too many types, and long ones are no type
+		if( (MIN_FUZZY_LENGTH > textLen) || (MAX_DELIVERY_LINE_ELEMENT_SIZE < textLen)) return( (const S_CONVERSION_TYPE *) 0x0);
+		int bound = (8 > textLen) ? 1 : MAX_FUZZY_DISTANCE;
+		if( maxDistance < bound) bound = maxDistance;
+		if( 0 >= bound) return( (const S_CONVERSION_TYPE *) 0x0);
+
+		// The pattern - letters only
+		S_FUZZY_PATTERN pattern;
+		memset( pattern.allMasks, 0x0, sizeof( pattern.allMasks));
+		for( size_t nPos = 0; textLen > nPos; ++ nPos) {
+			const unsigned letter = (unsigned) (text[nPos] - 'A');
+			if( 26 <= letter) return( (const S_CONVERSION_TYPE *) 0x0);
+			pattern.allMasks[letter] |= (1ULL << nPos);
+		}
+		pattern.lastBit = 1ULL << (textLen - 1);
+		pattern.length = (int) textLen;
+
+		// Every type close enough in length - misspellings rarely start wrong, and short
+		// words a letter apart at the start are often real names (KING and XING)
+		const S_CONVERSION_TYPE *ctBest = (const S_CONVERSION_TYPE *) 0x0;
+		int bestDistance = bound + 1;
+		bool bTied = false;
+		for( size_t nType = 0; nTypes > nType; ++ nType) {
+			if( text[0] != allTypes[nType].type[0]) continue;
+			const size_t typeLen = strlen( allTypes[nType].type);
+			if( (typeLen + bound < textLen) || (textLen + bound < typeLen)) continue;
+			const int distance = fuzzyDistance( pattern, allTypes[nType].type, typeLen);
+
+			// One letter changed in a short word is usually another word (STATE and STATN)
+			if( (1 == distance) && (typeLen == textLen) && (MIN_FUZZY_SUBSTITUTION_LENGTH > textLen) && ! sameLetters( text, allTypes[nType].type, textLen)) continue;
+			if( distance < bestDistance) {
+				ctBest = allTypes + nType;
+				bestDistance = distance;
+				bTied = false;
+			}
+			else if( (distance == bestDistance) && ((const S_CONVERSION_TYPE *) 0x0 != ctBest) && (0x0 != strcmp( ctBest->preftype, allTypes[nType].preftype))) {
+				bTied = true;
+			}
+		}
+		return( bTied ? (const S_CONVERSION_TYPE *) 0x0 : ctBest);
 
-		// Copy the input into a delivery line
-		deliveryLine dl( addrLine);
+	}
+
+	// Closest street type
+	const S_CONVERSION_TYPE * addressCompression::lookupStreetTypeFuzzy( const char *streetType, const size_t typeLen, const int maxDistance) const {
+		if( (const addressDictionary *) 0x0 != pDictionary) return( closestConversion( pDictionary->getEntries( DT_STREET_TYPES), pDictionary->getCount( DT_STREET_TYPES), streetType, typeLen, maxDistance));
+		return( closestConversion( KNOWN_STREET_TYPES, N_STREET_TYPES, streetType, typeLen, maxDistance));
+	}
+
+	// Closest unit type
+	const S_CONVERSION_TYPE * addressCompression::lookupUnitTypeFuzzy( const char *unitType, const size_t typeLen, const int maxDistance) const {
+		if( (const addressDictionary *) 0x0 != pDictionary) return( closestConversion( pDictionary->getEntries( DT_UNIT_TYPES), pDictionary->getCount( DT_UNIT_TYPES), unitType, typeLen, maxDistance));
+		return( closestConversion( KNOWN_UNIT_TYPES, N_UNIT_TYPES, unitType, typeLen, maxDistance));
+	}
+
+	// Lookup other conversion
+	const S_CONVERSION_TYPE * addressCompression::lookupOtherConversion( const char *otherValue) const {
+		return( lookupOtherConversion( otherValue, strlen( otherValue)));
+	}
+
+	// Lookup other conversion of known length
+	const S_CONVERSION_TYPE * addressCompression::lookupOtherConversion( const char *otherValue, const size_t valueLen) const {
+		if( (const addressDictionary *) 0x0 != pDictionary) return( pDictionary->lookup( DT_OTHER_CONVERSION, otherValue, valueLen));
+		return( OTHER_CONVERSION_INDEX.find( OTHER_CONVERSION, otherValue, valueLen));
+	}
+
+	// Is a cleaned token a directional?
+	bool addressCompression::isDirectional( const char *pText, const size_t textLen) const {
+		if( (const addressDictionary *) 0x0 != pDictionary) return( (const S_CONVERSION_TYPE *) 0x0 != pDictionary->lookup( DT_DIRECTIONALS, pText, textLen));
+		if( 2 < textLen) return( false);
+		for( int nPos = 0; (const char *) 0x0 != KNOWN_DIRECTIONALS[nPos]; ++ nPos) {
+			if( (0x0 == strncmp( pText, KNOWN_DIRECTIONALS[nPos], textLen)) && (0x0 == KNOWN_DIRECTIONALS[nPos][textLen])) return( true);
+		}
+		return( false);
+	}
+
+	// Match a PO box or rural route header
+	E_LINE_COMPONENT addressCompression::matchLineHeader( const char *text, size_t &headerLen, size_t &nHeader) const {
+		if( (const addressDictionary *) 0x0 != pDictionary) return( pDictionary->matchLineHeader( text, headerLen, nHeader));
+		const uint16_t headerAccept = LINE_HEADER_AUTOMATON.match( text, headerLen);
+		if( 0 == headerAccept) return( LC_COUNT);
+		nHeader = (headerAccept & 0xFF) - 1;
+		return( (HEADER_LIST_PO_BOX == (headerAccept >> 8)) ? LC_PO_BOX : LC_RURAL_ROUTE);
+	}
+
+	// The form written for a rural route header
+	const char * addressCompression::getRuralRouteForm( const size_t nHeader) const {
+		if( (const addressDictionary *) 0x0 != pDictionary) return( pDictionary->getEntries( DT_RURAL_ROUTE_HEADERS)[nHeader].preftype);
+		return( RURAL_ROUTE_FORMS[nHeader]);
+	}
+
+	// Build the normalized line for a parsed delivery line - defined with the parsing helpers
+	static size_t writeNormalizedLine( const addressCompression &addrComp, const deliveryLine &dl, char *outLine, const size_t outLineSize);
+
+	// Normalize a line in place
+	size_t addressCompression::normalizeDeliveryLine( char *addrLine, const size_t allocStringSize) {
+
+		// Trivial?
+		if( (char *) 0x0 == addrLine) return( 0);
+		if( 0x0 == allocStringSize) return( 0);
+		if( 0x0 == addrLine[0]) return( 0);
 
 		// Ignore if there is no street name
-		if( 0x0 == dl.getStreetName()[0]) return;
-
-		// Normalize the street name
-		char origStreetName [MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
-		memset( origStreetName, 0x0, sizeof( origStreetName));
-		char newStreetName [MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
-		char *lasts = (char *) 0x0;
-		memset( newStreetName, 0x0, sizeof( newStreetName));
-		strcpy( origStreetName, dl.getStreetName());
-		char *snToken = strtok_r( origStreetName, " ", &lasts);
-		while( (char *) 0x0 != snToken) {
-			S_CONVERSION_TYPE key = { snToken , (const char *) 0x0 };
-			S_CONVERSION_TYPE *ctNode = (S_CONVERSION_TYPE *) bsearch( &key, OTHER_CONVERSION, nOtherConversion, sizeof( S_CONVERSION_TYPE), compareConversionType);
-			if( (S_CONVERSION_TYPE *) 0x0 == ctNode)
-				strcat( newStreetName, snToken);
-			else
-				strcat( newStreetName, ctNode->preftype);
-			strcat( newStreetName, " ");
-			snToken = strtok_r( (char *) 0x0, " ", &lasts);
+		deliveryLine dl;
+		S_PARSE_SCRATCH scratch;
+		scratch.pDictionary = pDictionary;
+		scratch.maxEditDistance = 0;
+		dl.parseLine( addrLine, strnlen( addrLine, MAX_DELIVERY_LINE_ELEMENT_SIZE * 4), scratch);
+		if( 0x0 == dl.getStreetName()[0]) return( strnlen( addrLine, allocStringSize));
+
+		// The parse holds its own copy, so the result can go straight over the input
+		return( writeNormalizedLine( *this, dl, addrLine, allocStringSize));
+
+	}
+
+	// Normalize a line into a separate buffer
+	size_t addressCompression::normalizeDeliveryLine( const char *addrLine, char *outLine, const size_t outLineSize) const {
+
+		// Trivial?
+		if( ((char *) 0x0 == outLine) || (0x0 == outLineSize)) return( 0);
+		outLine[0] = 0x0;
+		if( (const char *) 0x0 == addrLine) return( 0);
+
+		// A line with no street name is copied as is
+		deliveryLine dl;
+		S_PARSE_SCRATCH scratch;
+		scratch.pDictionary = pDictionary;
+		scratch.maxEditDistance = 0;
+		dl.parseLine( addrLine, strnlen( addrLine, MAX_DELIVERY_LINE_ELEMENT_SIZE * 4), scratch);
+		if( 0x0 == dl.getStreetName()[0]) {
+			const size_t lineLen = strnlen( addrLine, outLineSize - 1);
+			memcpy( outLine, addrLine, lineLen);
+			outLine[lineLen] = 0x0;
+			return( lineLen);
+		}
+
+		return( writeNormalizedLine( *this, dl, outLine, outLineSize));
+
+	}
+
+	// Pre-pass character classes
+	#define	PREPASS_KEEP			(0)
+	#define	PREPASS_SPACE			(1)
+	#define	PREPASS_PUNCT			(2)
+
+	// Classify one input byte - ASCII punctuation except '#' is dropped
+	static inline int prepassClass( const unsigned char cValue) {
+		if( (' ' == cValue) || (('\t' <= cValue) && ('\r' >= cValue))) return( PREPASS_SPACE);
+		if( '#' == cValue) return( PREPASS_KEEP);
+		if( ((0x21 <= cValue) && (0x2F >= cValue)) || ((0x3A <= cValue) && (0x40 >= cValue)) ||
+		   	((0x5B <= cValue) && (0x60 >= cValue)) || ((0x7B <= cValue) && (0x7E >= cValue))) return( PREPASS_PUNCT);
+		return( PREPASS_KEEP);
+	}
+
+	// Mark a copied digit in the scratch digit bitmap
+	static inline void prepassDigitBits( S_PARSE_SCRATCH &scratch, const size_t nCopyPos, const uint64_t digitMask) {
+		const size_t nShift = nCopyPos & 63;
+		scratch.digitBits[nCopyPos >> 6] |= digitMask << nShift;
+		if( (0 != nShift) && (0 != (digitMask >> (64 - nShift)))) scratch.digitBits[(nCopyPos >> 6) + 1] |= digitMask >> (64 - nShift);
+	}
+
+	// Add one classified byte to the cleaned copy, recording token starts
+	static inline void prepassByte( S_PARSE_SCRATCH &scratch, size_t &nCopyPos, bool &lastWasSpace, const unsigned char cValue, const int cClass) {
+		if( PREPASS_SPACE == cClass) {
+			if( ! lastWasSpace) scratch.copyValue[nCopyPos ++] = ' ';
+			lastWasSpace = true;
 		}
-		newStreetName[strlen( newStreetName) - 1] = 0x0;
-
-		// Put it all back together
-		char retLine[MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
-		memset( retLine, 0x0, sizeof( retLine));
-		if( 0x0 != dl.getStreetNumber()[0]) {
-			strcat( retLine, dl.getStreetNumber());
-			strcat( retLine, " ");
+		else if( PREPASS_KEEP == cClass) {
+			if( lastWasSpace && (MAX_DELIVERY_LINE_TOKENS > scratch.nTokens)) scratch.tokens[scratch.nTokens ++].offset = (uint16_t) nCopyPos;
+			if( ('0' <= cValue) && ('9' >= cValue)) prepassDigitBits( scratch, nCopyPos, 1);
+			scratch.copyValue[nCopyPos ++] = (char) cValue;
+			lastWasSpace = false;
 		}
-		if( 0x0 != dl.getPreDirectional()[0]) {
-			strcat( retLine, dl.getPreDirectional());
-			strcat( retLine, " ");
+	}
+
+	// Fold one byte to upper case (ASCII only)
+	static inline unsigned char prepassUpper( const unsigned char cValue) {
+		return( (('a' <= cValue) && ('z' >= cValue)) ? (unsigned char) (cValue - 0x20) : cValue);
+	}
+
+#if defined( __SSE2__)
+	// Mask of bytes within [lowValue, highValue] - both below 0x80
+	static inline __m128i prepassInRange( const __m128i block, const char lowValue, const char highValue) {
+		return( _mm_and_si128( _mm_cmpgt_epi8( block, _mm_set1_epi8( lowValue - 1)), _mm_cmplt_epi8( block, _mm_set1_epi8( highValue + 1))));
+	}
+#endif
+
+	// Are all the digit bits from nFrom for nCount bytes set?
+	static inline bool allDigitBits( const S_PARSE_SCRATCH &scratch, size_t nFrom, size_t nCount) {
+		while( 0 < nCount) {
+			const size_t nShift = nFrom & 63;
+			const size_t nBits = ((64 - nShift) < nCount) ? (64 - nShift) : nCount;
+			const uint64_t wantBits = ((64 == nBits) ? ~(uint64_t) 0 : (((uint64_t) 1 << nBits) - 1)) << nShift;
+			if( wantBits != (scratch.digitBits[nFrom >> 6] & wantBits)) return( false);
+			nFrom += nBits;
+			nCount -= nBits;
 		}
-		strcat( retLine, newStreetName);
-		strcat( retLine, " ");
-		if( 0x0 != dl.getStreetType()[0]) {
-			strcat( retLine, dl.getStreetType());
-			strcat( retLine, " ");
+		return( true);
+	}
+
+	// Fill in the length and flags of every token
+	static void finishTokens( S_PARSE_SCRATCH &scratch) {
+		for( size_t nToken = 0; scratch.nTokens > nToken; ++ nToken) {
+			S_TOKEN &token = scratch.tokens[nToken];
+			const char *pText = scratch.copyValue + token.offset;
+			token.length = (uint16_t) (((nToken + 1) < scratch.nTokens) ? (scratch.tokens[nToken + 1].offset - 1 - token.offset) : strcspn( pText, " "));
+			token.flags = 0;
+			if( ('0' <= pText[0]) && ('9' >= pText[0])) token.flags |= TOKEN_NUMERIC_START;
+			if( allDigitBits( scratch, token.offset, token.length)) token.flags |= TOKEN_ALL_DIGITS;
+			if( '#' == pText[0]) token.flags |= ((1 == token.length) ? (TOKEN_HASH_START | TOKEN_HASH_ONLY) : TOKEN_HASH_START);
+		}
+	}
+
+	//
+	// Clean the input into the scratch copy and build the token table in one pass
+	//
+	// Upper cases ASCII, drops punctuation other than '#' and collapses any
+	// run of white space to a single blank.  The copy has no leading or
+	// trailing blanks.  Blocks of 16 bytes are classified with SSE2 where
+	// available; a block with no punctuation or doubled white space is
+	// stored as is.  Token starts and digits are noted as bytes are copied,
+	// so the token table is finished without looking at the text again.
+	//
+	static void prepassInput( const char *inputLine, size_t inputLen, S_PARSE_SCRATCH &scratch) {
+
+		// Stop at a terminator or the copy limit
+		if( (MAX_DELIVERY_LINE_ELEMENT_SIZE * 4) < inputLen) inputLen = MAX_DELIVERY_LINE_ELEMENT_SIZE * 4;
+		const void *pTerm = memchr( inputLine, 0x0, inputLen);
+		if( (const void *) 0x0 != pTerm) inputLen = (const char *) pTerm - inputLine;
+
+		const unsigned char *pInput = (const unsigned char *) inputLine;
+		size_t nPos = 0, nCopyPos = 0;
+		bool lastWasSpace = true;
+		scratch.nTokens = 0;
+		memset( scratch.digitBits, 0x0, sizeof( scratch.digitBits));
+
+#if defined( __SSE2__)
+		for( ; inputLen >= (nPos + 16); nPos += 16) {
+
+			// Classify the block
+			const __m128i block = _mm_loadu_si128( (const __m128i *) (pInput + nPos));
+			const __m128i isLower = prepassInRange( block, 'a', 'z');
+			const __m128i isSpace = _mm_or_si128( _mm_cmpeq_epi8( block, _mm_set1_epi8( ' ')), prepassInRange( block, '\t', '\r'));
+			__m128i folded = _mm_sub_epi8( block, _mm_and_si128( isLower, _mm_set1_epi8( 0x20)));
+			folded = _mm_or_si128( _mm_andnot_si128( isSpace, folded), _mm_and_si128( isSpace, _mm_set1_epi8( ' ')));
+			__m128i isPunct = _mm_or_si128(
+				_mm_or_si128( prepassInRange( block, 0x21, 0x2F), prepassInRange( block, 0x3A, 0x40)),
+				_mm_or_si128( prepassInRange( block, 0x5B, 0x60), prepassInRange( block, 0x7B, 0x7E)));
+			isPunct = _mm_andnot_si128( _mm_cmpeq_epi8( block, _mm_set1_epi8( '#')), isPunct);
+			const unsigned int spaceMask = (unsigned int) _mm_movemask_epi8( isSpace);
+			const unsigned int punctMask = (unsigned int) _mm_movemask_epi8( isPunct);
+			const unsigned int digitMask = (unsigned int) _mm_movemask_epi8( prepassInRange( block, '0', '9'));
+			const unsigned int prevSpace = ((spaceMask << 1) | (lastWasSpace ? 1 : 0)) & 0xFFFF;
+
+			// Nothing to drop - store it whole
+			if( (0 == punctMask) && (0 == (spaceMask & prevSpace))) {
+				_mm_storeu_si128( (__m128i *) (scratch.copyValue + nCopyPos), folded);
+				unsigned int tokenStarts = ~spaceMask & prevSpace;
+				while( 0 != tokenStarts) {
+					if( MAX_DELIVERY_LINE_TOKENS > scratch.nTokens) scratch.tokens[scratch.nTokens ++].offset = (uint16_t) (nCopyPos + __builtin_ctz( tokenStarts));
+					tokenStarts &= tokenStarts - 1;
+				}
+				if( 0 != digitMask) prepassDigitBits( scratch, nCopyPos, digitMask);
+				nCopyPos += 16;
+				lastWasSpace = (0 != (spaceMask & 0x8000));
+				continue;
+			}
+
+			// Otherwise byte by byte from the masks
+			unsigned char acFolded [16];
+			_mm_storeu_si128( (__m128i *) acFolded, folded);
+			for( int nByte = 0; 16 > nByte; ++ nByte) {
+				const int cClass = (spaceMask & (1u << nByte)) ? PREPASS_SPACE : ((punctMask & (1u << nByte)) ? PREPASS_PUNCT : PREPASS_KEEP);
+				prepassByte( scratch, nCopyPos, lastWasSpace, acFolded[nByte], cClass);
+			}
+
 		}
-		if( 0x0 != dl.getPostDirectional()[0]) {
-			strcat( retLine, dl.getPostDirectional());
-			strcat( retLine, " ");
+#endif
+
+		// Whatever is left
+		for( ; inputLen > nPos; ++ nPos) {
+			prepassByte( scratch, nCopyPos, lastWasSpace, prepassUpper( pInput[nPos]), prepassClass( pInput[nPos]));
 		}
-		if( 0x0 != dl.getUnitType()[0]) {
-			strcat( retLine, dl.getUnitType());
-			strcat( retLine, " ");
+
+		// No trailing blank
+		if( (0 < nCopyPos) && (' ' == scratch.copyValue[nCopyPos - 1])) -- nCopyPos;
+		scratch.copyValue[nCopyPos] = 0x0;
+		finishTokens( scratch);
+
+	}
+
+	// Zero terminate every token in place
+	static void terminateTokens( S_PARSE_SCRATCH &scratch) {
+		for( size_t nToken = 0; scratch.nTokens > nToken; ++ nToken) scratch.copyValue[scratch.tokens[nToken].offset + scratch.tokens[nToken].length] = 0x0;
+	}
+
+	// Split a lone token at its first '#' - as in "Rural Route 5#332"
+	// Returns the number of tokens left
+	static size_t splitLoneToken( S_PARSE_SCRATCH &scratch, S_TOKEN *allTokens) {
+		S_TOKEN &token = allTokens[0];
+		char *pText = scratch.copyValue + token.offset;
+		while( (0 < token.length) && ('#' == *pText)) {
+			++ pText;
+			++ token.offset;
+			-- token.length;
 		}
-		if( 0x0 != dl.getUnitNumber()) {
-			strcat( retLine, dl.getUnitNumber());
-			strcat( retLine, " ");
+		if( 0 == token.length) return( 0);
+		char *pHash = strchr( pText, '#');
+		if( (char *) 0x0 == pHash) return( 1);
+		*pHash = 0x0;
+		const uint16_t nRestLen = (uint16_t) (token.length - (pHash - pText) - 1);
+		token.length = (uint16_t) (pHash - pText);
+		if( 0 == nRestLen) return( 1);
+		allTokens[1].offset = (uint16_t) (pHash + 1 - scratch.copyValue);
+		allTokens[1].length = nRestLen;
+		allTokens[1].flags = ('#' == pHash[1]) ? ((1 == nRestLen) ? (TOKEN_HASH_START | TOKEN_HASH_ONLY) : TOKEN_HASH_START) : 0;
+		return( 2);
+	}
+
+	// Previous token still in use - or -1
+	static inline long prevLiveToken( const S_TOKEN *allTokens, long nToken) {
+		for( -- nToken; (0 <= nToken) && (0 != (TOKEN_REMOVED & allTokens[nToken].flags)); -- nToken);
+		return( nToken);
+	}
+
+	// Next token still in use - or nTokens
+	static inline long nextLiveToken( const S_TOKEN *allTokens, const long nTokens, long nToken) {
+		for( ++ nToken; (nTokens > nToken) && (0 != (TOKEN_REMOVED & allTokens[nToken].flags)); ++ nToken);
+		return( nToken);
+	}
+
+	// Append a token to a value, blank separated - returns false if it does not fit
+	static inline bool appendToken( char *pValue, const size_t valueSize, size_t &valueLen, const char *pText, const size_t textLen) {
+		if( valueSize <= (valueLen + textLen + ((0 < valueLen) ? 1 : 0))) return( false);
+		if( 0 < valueLen) pValue[valueLen ++] = ' ';
+		memcpy( pValue + valueLen, pText, textLen);
+		valueLen += textLen;
+		pValue[valueLen] = 0x0;
+		return( true);
+	}
+
+	// Append a zero terminated component to a line, blank separated - empty components are skipped
+	static inline void appendComponent( char *pLine, const size_t lineSize, size_t &lineLen, const char *pValue) {
+		if( 0x0 != pValue[0]) appendToken( pLine, lineSize, lineLen, pValue, strlen( pValue));
+	}
+
+	// Longest normalized line - every street component and a blank after each
+	#define	MAX_NORMALIZED_LINE		(8 * (MAX_DELIVERY_LINE_ELEMENT_SIZE + 1))
+
+	//
+	// Build the normalized line for a parsed delivery line
+	//
+	// The street components are joined by single blanks in one forward
+	// pass, with the other conversions applied to each street name word.
+	// Returns the length written to outLine, which is always terminated.
+	//
+	static size_t writeNormalizedLine( const addressCompression &addrComp, const deliveryLine &dl, char *outLine, const size_t outLineSize) {
+
+		char acLine [MAX_NORMALIZED_LINE + 1];
+		size_t lineLen = 0;
+
+		// Number and pre-directional
+		appendComponent( acLine, sizeof( acLine), lineLen, dl.getStreetNumber());
+		appendComponent( acLine, sizeof( acLine), lineLen, dl.getPreDirectional());
+
+		// The street name, a word at a time
+		const char *pWord = dl.getStreetName();
+		while( 0x0 != *pWord) {
+			size_t wordLen = strcspn( pWord, " ");
+			if( 0 < wordLen) {
+				const S_CONVERSION_TYPE *ctNode = addrComp.lookupOtherConversion( pWord, wordLen);
+				if( (const S_CONVERSION_TYPE *) 0x0 == ctNode) appendToken( acLine, sizeof( acLine), lineLen, pWord, wordLen);
+				else appendComponent( acLine, sizeof( acLine), lineLen, ctNode->preftype);
+			}
+			pWord += wordLen;
+			while( ' ' == *pWord) ++ pWord;
 		}
-		size_t nSize = strlen( retLine) - 1;
-		while( ' ' == retLine [nSize]) retLine [nSize --] = 0x0;
 
-		// Copy the result back into the input
-		strncpy( addrLine, retLine, allocStringSize);
+		// And the rest
+		appendComponent( acLine, sizeof( acLine), lineLen, dl.getStreetType());
+		appendComponent( acLine, sizeof( acLine), lineLen, dl.getPostDirectional());
+		appendComponent( acLine, sizeof( acLine), lineLen, dl.getUnitType());
+		appendComponent( acLine, sizeof( acLine), lineLen, dl.getUnitNumber());
+
+		// Copy out as much as fits
+		if( outLineSize <= lineLen) lineLen = outLineSize - 1;
+		memcpy( outLine, acLine, lineLen);
+		outLine[lineLen] = 0x0;
+		return( lineLen);
 
 	}
 
+	// Construct an empty delivery line
+	deliveryLine::deliveryLine() {
+		clearAll();
+	}
+
 	// Construct a delivery line
 	deliveryLine::deliveryLine( const char *inputLine) {
 
-		// Clear values
+		// Scratch space lives on the stack for one-off parses
+		S_PARSE_SCRATCH scratch;
+		scratch.pDictionary = (const addressDictionary *) 0x0;
+		scratch.maxEditDistance = 0;
+		clearAll();
+		if( (const char *) 0x0 == inputLine) return;
+		parseLine( inputLine, strnlen( inputLine, MAX_DELIVERY_LINE_ELEMENT_SIZE * 4), scratch);
+
+	}
+
+	// Clear every byte of the values
+	void deliveryLine::clearAll() {
 		memset( acStreetNum, 0x0, sizeof( acStreetNum));
 		memset( acPreDirectional, 0x0, sizeof( acPreDirectional));
 		memset( acStreetName, 0x0, sizeof( acStreetName));
@@ -804,311 +1335,512 @@ namespace libAddr {
 		memset( acPOBox, 0x0, sizeof( acPOBox));
 		memset( acRuralRoute, 0x0, sizeof( acRuralRoute));
 		memset( acRemainder, 0x0, sizeof( acRemainder));
+		acFullLine[0] = 0x0;
+		nNoNumberOffset = -1;
+	}
 
-		// Trivial?
-		if( (const char *) 0x0 == inputLine) return;
-		if( 0x0 == inputLine[0]) return;
-
-		// Allocate space for the tokens
-		addressCompression addrComp;
-		typedef std::vector<char *> CNT_STRPTR;
-		typedef CNT_STRPTR::iterator ITR_STRPTR;
-		CNT_STRPTR allTokens;
-
-		// Make a copy of the input, removing punctuation
-		char copyValue [MAX_DELIVERY_LINE_ELEMENT_SIZE * 4 + 1];
-		memset( copyValue, 0x0, sizeof( copyValue));
-		int nPos, nCopyPos;
-		nPos = nCopyPos = 0;
-		for( ; ((MAX_DELIVERY_LINE_ELEMENT_SIZE * 4) > nPos) && (0x0 != inputLine[nPos]); ++ nPos) {
-			if( ('#' == inputLine[nPos]) || (! ispunct( inputLine[nPos]))) copyValue[nCopyPos ++] = toupper(inputLine[nPos]);
-		}
+	// Clear the values for another parse
+	// Every writer keeps the last byte of a value zero, so only the first needs resetting
+	void deliveryLine::clear() {
+		acStreetNum[0] = 0x0;
+		acPreDirectional[0] = 0x0;
+		acStreetName[0] = 0x0;
+		acStreetType[0] = 0x0;
+		acPostDirectional[0] = 0x0;
+		acUnitType[0] = 0x0;
+		acUnitNumber[0] = 0x0;
+		acPOBox[0] = 0x0;
+		acRuralRoute[0] = 0x0;
+		acRemainder[0] = 0x0;
+		nNoNumberOffset = -1;
+	}
 
-		// PO Box?
-		bool isPOBox = false;
-		for( int nPO = 0x0; addressCompression::KNOWN_PO_BOX_HEADERS [nPO] != (const char *) 0x0; ++ nPO) {
-			if( 0x0 == strncmp( addressCompression::KNOWN_PO_BOX_HEADERS [nPO], copyValue, strlen( addressCompression::KNOWN_PO_BOX_HEADERS [nPO]))) {
-				// Remove box prefix - clears for later tokenization
-				memset( copyValue, ' ', strlen(addressCompression::KNOWN_PO_BOX_HEADERS [nPO]));
-				isPOBox = true;
-				break;
-			}
+	// Build the full line in one forward pass
+	void deliveryLine::buildFullLine() const {
+
+		// Every value in line order, the street number first
+		const char *allValues [LC_COUNT] = {
+			acStreetNum, acPreDirectional, acStreetName, acStreetType, acPostDirectional,
+			acUnitType, acUnitNumber, acPOBox, acRuralRoute, acRemainder
+		};
+		char *pOutput = acFullLine;
+		const char *pEnd = acFullLine + MAX_FULL_LINE_SIZE;
+		for( int nComp = 0; LC_COUNT > nComp; ++ nComp) {
+			const char *pValue = allValues[nComp];
+			if( 0x0 == pValue[0]) continue;
+			if( (acFullLine != pOutput) && (pEnd > pOutput)) *pOutput++ = ' ';
+			while( (0x0 != *pValue) && (pEnd > pOutput)) *pOutput++ = *pValue++;
 		}
+		*pOutput = 0x0;
 
-		// Rural route?
-		bool isRuralRoute = false;
-		for( int nRR = 0x0; addressCompression::KNOWN_RURAL_ROUTE_HEADERS [nRR] != (const char *) 0x0; ++ nRR) {
-			if( 0x0 == strncmp( addressCompression::KNOWN_RURAL_ROUTE_HEADERS [nRR], copyValue, strlen( addressCompression::KNOWN_RURAL_ROUTE_HEADERS [nRR]))) {
-				// Remove RR prefix - clears for later tokenization
-				memset( copyValue, ' ', strlen(addressCompression::KNOWN_RURAL_ROUTE_HEADERS [nRR]));
-				isRuralRoute = true;
-				break;
-			}
+		// Without the number the line starts at the next value - or is blank without a street
+		const int fullLen = (int) (pOutput - acFullLine);
+		const int numberLen = (int) strlen( acStreetNum);
+		if( 0x0 == acStreetName[0]) nNoNumberOffset = fullLen;
+		else if( 0 == numberLen) nNoNumberOffset = 0;
+		else nNoNumberOffset = (fullLen > numberLen) ? (numberLen + 1) : fullLen;
+
+	}
+
+	// Return the full, clean line
+	const char * deliveryLine::getFullLine() const {
+		if( -1 == nNoNumberOffset) buildFullLine();
+		return( acFullLine);
+	}
+
+	// Return the full, clean line without the street number
+	const char * deliveryLine::getFullLineNoNumber() const {
+		if( -1 == nNoNumberOffset) buildFullLine();
+		return( acFullLine + nNoNumberOffset);
+	}
+
+	// Join the live tokens from nFirstToken on into the remainder
+	void deliveryLine::captureRemainder( const char *copyValue, const S_TOKEN *allTokens, const long nTokens, const long nFirstToken) {
+		size_t remainderLen = 0;
+		acRemainder[0] = 0x0;
+		for( long nPos = nFirstToken; nTokens > nPos; ++ nPos) {
+			if( 0 != (TOKEN_REMOVED & allTokens[nPos].flags)) continue;
+			if( ! appendToken( acRemainder, sizeof( acRemainder), remainderLen, copyValue + allTokens[nPos].offset, allTokens[nPos].length)) break;
 		}
+	}
 
+	// Parse a line into the values
+	void deliveryLine::parseLine( const char *inputLine, const size_t inputLen, S_PARSE_SCRATCH &scratch, const E_PARSE_ENGINE engine) {
 
-		// Tokenize
-		char *lasts = (char *) 0x0;
-		char *token = strtok_r( copyValue, " \t", &lasts);
-		while( (char *) 0x0 != token) {
-			allTokens.push_back( token);
-			token = strtok_r( (char *) 0x0, " \t", &lasts);
+		// Trivial?
+		INSTRUMENT_START();
+		clear();
+		if( (const char *) 0x0 == inputLine) return;
+		if( (0x0 == inputLen) || (0x0 == inputLine[0])) return;
+
+		// Make a clean copy of the input and build the token table
+		prepassInput( inputLine, inputLen, scratch);
+		INSTRUMENT_LAP( PS_PREPASS);
+		parseTokens( scratch, engine);
+
+	}
+
+	// Parse the values from the cleaned copy - the values must already be clear
+	void deliveryLine::parseTokens( S_PARSE_SCRATCH &scratch, const E_PARSE_ENGINE engine) {
+
+		// Dictionary lookups
+		const addressCompression addrComp( scratch.pDictionary);
+		char *copyValue = scratch.copyValue;
+		if( 0 == scratch.nTokens) return;
+
+		// PO Box or rural route?  One scan finds the longest header of either
+		size_t headerLen = 0, nHeader = 0;
+		const E_LINE_COMPONENT header = addrComp.matchLineHeader( copyValue, headerLen, nHeader);
+		const bool isPOBox = (LC_PO_BOX == header);
+		const bool isRuralRoute = (LC_RURAL_ROUTE == header);
+		INSTRUMENT_LAP( PS_HEADER_MATCH);
+
+		// Step over the header tokens and terminate the rest
+		terminateTokens( scratch);
+		S_TOKEN *allTokens = scratch.tokens;
+		long nTokens = (long) scratch.nTokens;
+		while( (0 < nTokens) && (allTokens[0].offset < headerLen)) {
+			++ allTokens;
+			-- nTokens;
 		}
+		INSTRUMENT_LAP( PS_TOKENIZE);
+
+		// Nothing left once punctuation is gone?
+		if( 0 == nTokens) return;
 
 		// PO Box?
 		if( isPOBox) {
-			if( allTokens.size() >= 2) {
-				sprintf( acPOBox, "PO BOX %s", allTokens[1]);
-			}
-			for( int nToken = 2; allTokens.size() > nToken; ++ nToken) {
-				strcat( acRemainder, allTokens[nToken]);
-				strcat( acRemainder, " ");
-			}
+			INSTRUMENT_COUNT( PB_PO_BOX);
+			snprintf( acPOBox, sizeof( acPOBox), "PO BOX %s", copyValue + allTokens[0].offset);
+			captureRemainder( copyValue, allTokens, nTokens, 1);
+			INSTRUMENT_LAP( PS_ASSEMBLY);
 			return;
 		}
 
 		// Rural route?
 		if( isRuralRoute) {
 
-			int nextToken = 1;
+			INSTRUMENT_COUNT( PB_RURAL_ROUTE);
+			long nextToken = 1;
 
 			// Potential case of "Rural Route RR#BOX"
-			if( allTokens.size() == 1) {
-				allTokens.clear();
-				lasts = (char *) 0x0;
-				token = strtok_r( copyValue, " \t#", &lasts);
-				while( (char *) 0x0 != token) {
-					allTokens.push_back( token);
-					token = strtok_r( (char *) 0x0, " \t", &lasts);
-				}
+			if( 1 == nTokens) {
+				nTokens = (long) splitLoneToken( scratch, allTokens);
 			}
 
 			// Enough for rural route & box
-			if( allTokens.size() >= 2) {
+			if( 2 <= nTokens) {
 
 				// Or rural route as least!
-				sprintf( acRuralRoute, "RURAL ROUTE %s", allTokens[0]);
+				snprintf( acRuralRoute, sizeof( acRuralRoute), "%s %s", addrComp.getRuralRouteForm( nHeader), copyValue + allTokens[0].offset);
 
 				// Jump the box header
-				if( (0x0 == strcmp( allTokens[nextToken], "#")) ||
-				   	(0x0 == strcmp( allTokens[nextToken], "BOX")) ||
-				   	(0x0 == strcmp( allTokens[nextToken], "UNIT"))) {
+				const char *pText = copyValue + allTokens[nextToken].offset;
+				if( (0 != (TOKEN_HASH_ONLY & allTokens[nextToken].flags)) ||
+				   	(0x0 == strcmp( pText, "BOX")) ||
+				   	(0x0 == strcmp( pText, "UNIT"))) {
 					++ nextToken;
 				}
 
 				// Capture the box
-				if( allTokens.size() > nextToken) {
-					strcat( acRuralRoute, " BOX ");
-					if( '#' != allTokens[nextToken][0])
-						strcat( acRuralRoute, allTokens[nextToken]);
-					else
-						strcat( acRuralRoute, (allTokens[nextToken]) + 1);
+				if( nTokens > nextToken) {
+					pText = copyValue + allTokens[nextToken].offset;
+					strncat( acRuralRoute, " BOX ", sizeof( acRuralRoute) - strlen( acRuralRoute) - 1);
+					strncat( acRuralRoute, ('#' != pText[0]) ? pText : (pText + 1), sizeof( acRuralRoute) - strlen( acRuralRoute) - 1);
 					++ nextToken;
 				}
 
 				// And remainder
-				for( ; allTokens.size() > nextToken; ++ nextToken) {
-					strcat( acRemainder, allTokens[nextToken]);
-					strcat( acRemainder, " ");
-				}
+				captureRemainder( copyValue, allTokens, nTokens, nextToken);
 			}
 
+			INSTRUMENT_LAP( PS_ASSEMBLY);
 			return;
 
 		} // endif rural route
 
-		// Starting from the right look for a sreet tyoe
-		unsigned long nStreetTypePos = -1;
-		unsigned long nCurToken = allTokens.size() - 1;
-		while( nCurToken > 1) {
-			char *pToken = allTokens[nCurToken];
-			S_CONVERSION_TYPE *ctNode = addrComp.lookupStreetType( pToken);
-			if( (S_CONVERSION_TYPE *) 0x0 != ctNode) {
+		// The street components
+		// Fuzzy corrections are only made by the rules
+		const bool bMachine = (PE_STATE_MACHINE == engine) && (0 == scratch.maxEditDistance);
+		const long nRemainder = bMachine ? parseStreetMachine( scratch, allTokens, nTokens) : parseStreetRules( scratch, allTokens, nTokens);
+		INSTRUMENT_COUNT( (0x0 != acStreetType[0]) ? PB_STREET_TYPE : PB_REMAINDER);
+
+		// Capture the remainder
+		captureRemainder( copyValue, allTokens, nTokens, nRemainder);
+
+		// Fix for numbered streets (like state highways)
+		if( (0x0 == acPostDirectional[0]) && (0x0 == acUnitType[0]) && (0x0 == acUnitNumber[0]) && (0x0 != acRemainder[0])) {
+
+			bool allNumbers = true;
+			for( long nPos = nRemainder; allNumbers && (nTokens > nPos); ++ nPos) {
+				allNumbers = (0 != (allTokens[nPos].flags & (TOKEN_ALL_DIGITS | TOKEN_REMOVED)));
+			}
+			if( allNumbers) {
+				char newValue[4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
+				snprintf( newValue, sizeof( newValue), "%s %s %s", acStreetName, acStreetType, acRemainder);
+				acStreetType[0] = 0x0;
+				acRemainder[0] = 0x0;
+				strncpy( acStreetName, newValue, MAX_DELIVERY_LINE_ELEMENT_SIZE);
+				INSTRUMENT_COUNT( PB_NUMBERED_HIGHWAY);
+			}
+
+		}
+		INSTRUMENT_LAP( PS_ASSEMBLY);
+
+	}
+
+	// Find the street components by searching the tokens
+	long deliveryLine::parseStreetRules( S_PARSE_SCRATCH &scratch, S_TOKEN *allTokens, const long nTokens) {
+
+		// Dictionary lookups
+		const addressCompression addrComp( scratch.pDictionary);
+		char *copyValue = scratch.copyValue;
+
+		// Starting from the right look for a street type
+		long nStreetTypePos = -1;
+		for( long nCurToken = nTokens - 1; 1 < nCurToken; -- nCurToken) {
+			const S_CONVERSION_TYPE *ctNode = addrComp.lookupStreetType( copyValue + allTokens[nCurToken].offset, allTokens[nCurToken].length);
+			if( (const S_CONVERSION_TYPE *) 0x0 != ctNode) {
 				nStreetTypePos = nCurToken;
 				strncpy( acStreetType, ctNode->preftype, (sizeof( acStreetType) / sizeof( acStreetType[0])) - 1);
 				break;
 			}
-			-- nCurToken;
 		}
 
+		// None spelled right - the nearest misspelling, if asked, that is not a unit, nor a
+		// misspelled one, nor a directional
+		if( (-1 == nStreetTypePos) && (0 != scratch.maxEditDistance)) {
+			for( long nCurToken = nTokens - 1; 1 < nCurToken; -- nCurToken) {
+				const S_TOKEN &token = allTokens[nCurToken];
+				const char *pText = copyValue + token.offset;
+				if( (const S_CONVERSION_TYPE *) 0x0 != addrComp.lookupUnitType( pText, token.length)) continue;
+				if( (const S_CONVERSION_TYPE *) 0x0 != addrComp.lookupUnitTypeFuzzy( pText, token.length, scratch.maxEditDistance)) continue;
+				if( addrComp.isDirectional( pText, token.length)) continue;
+				const S_CONVERSION_TYPE *ctNode = addrComp.lookupStreetTypeFuzzy( pText, token.length, scratch.maxEditDistance);
+				if( (const S_CONVERSION_TYPE *) 0x0 != ctNode) {
+					nStreetTypePos = nCurToken;
+					strncpy( acStreetType, ctNode->preftype, (sizeof( acStreetType) / sizeof( acStreetType[0])) - 1);
+					break;
+				}
+			}
+		}
+		INSTRUMENT_LAP( PS_STREET_TYPE_SCAN);
+
 		// If the street type was found, look left for apartment or unit type
-		unsigned long nUnitTypePos = -1;
+		// Tokens used up here are marked removed rather than erased
 		if( -1 != nStreetTypePos) {
 
-			// Look for the unit type
-			for( -- nCurToken; (0 <= nCurToken) && (allTokens.size() > nCurToken) ; -- nCurToken) {
-				char *pToken = allTokens[nCurToken];
-				S_CONVERSION_TYPE *ctNode = addrComp.lookupUnitType( pToken);
-				if( 0x0 == strcmp( pToken, "#")) {
+			long nUnitTypePos = -1;
+			for( long nCurToken = nStreetTypePos - 1; 0 <= nCurToken; -- nCurToken) {
+				const S_TOKEN &token = allTokens[nCurToken];
+				const char *pText = copyValue + token.offset;
+				if( 0 != (TOKEN_HASH_ONLY & token.flags)) {
 					nUnitTypePos = nCurToken;
 					strncpy( acUnitType, "UNIT", (sizeof( acUnitType) / sizeof( acUnitType[0])) - 1);
 					break;
 				}
-				else if( '#' == pToken[0]) {
+				else if( 0 != (TOKEN_HASH_START & token.flags)) {
 					strncpy( acUnitType, "UNIT", (sizeof( acUnitType) / sizeof( acUnitType[0])) - 1);
-					strncpy( acUnitNumber, pToken + 1, (sizeof( acUnitNumber) / sizeof( acUnitNumber[0])) - 1);
-					ITR_STRPTR itErase = allTokens.begin();
-					std::advance(itErase, nCurToken);
-					allTokens.erase( itErase);
-					nUnitTypePos = -1;
-					-- nStreetTypePos;
+					strncpy( acUnitNumber, pText + 1, (sizeof( acUnitNumber) / sizeof( acUnitNumber[0])) - 1);
+					allTokens[nCurToken].flags |= TOKEN_REMOVED;
 					break;
 				}
-				else if( (S_CONVERSION_TYPE *) 0x0 != ctNode) {
+				else if( (const S_CONVERSION_TYPE *) 0x0 != addrComp.lookupUnitType( pText, token.length)) {
 					nUnitTypePos = nCurToken;
-					strncpy( acUnitType, pToken, (sizeof( acUnitType) / sizeof( acUnitType[0])) - 1);
+					strncpy( acUnitType, pText, (sizeof( acUnitType) / sizeof( acUnitType[0])) - 1);
 					break;
 				}
 			}
 
-			// Extract the unit number information
-			if( 0 == nUnitTypePos) {
-				// Address starts with unit number
-				// Assume unit number is only the second part
-				// Then remove it from the tokens list becuase it will mess things up
-				strncpy( acUnitNumber, allTokens[1], (sizeof( acUnitNumber) / sizeof( acUnitNumber[0])) - 1);
-				allTokens.erase( allTokens.begin());
-				allTokens.erase( allTokens.begin());
-				nStreetTypePos -= 2;
-				nUnitTypePos = -1;
-			}
-			else if( -1 != nUnitTypePos) {
-				// Early find of the unit type and number
-				// Save it, but then remove them for the list
-				char *pToken = allTokens[nUnitTypePos + 1];
-				strncpy( acUnitNumber, pToken, (sizeof( acStreetType) / sizeof( acStreetType[0])) - 1);
-				ITR_STRPTR itErase = allTokens.begin();
-				std::advance(itErase, nUnitTypePos);
-				itErase = allTokens.erase( itErase);
-				allTokens.erase( itErase);
-				nStreetTypePos -= 2;
-				nUnitTypePos = -1;
+			// Save the unit number, but then remove both from the list
+			// The street type itself is never taken as the unit number
+			if( -1 != nUnitTypePos) {
+				if( nStreetTypePos > (nUnitTypePos + 1)) {
+					strncpy( acUnitNumber, copyValue + allTokens[nUnitTypePos + 1].offset, (sizeof( acUnitNumber) / sizeof( acUnitNumber[0])) - 1);
+					allTokens[nUnitTypePos + 1].flags |= TOKEN_REMOVED;
+				}
+				allTokens[nUnitTypePos].flags |= TOKEN_REMOVED;
 			}
+			if( 0x0 != acUnitType[0]) INSTRUMENT_COUNT( PB_UNIT_BEFORE_STREET);
+			INSTRUMENT_LAP( PS_UNIT_SCAN);
 
 		}
 
-		// If a street type was found, then find other values
-		unsigned long nRemainder = 0;
-		if( -1 != nStreetTypePos) {
-
-			nRemainder = nStreetTypePos + 1;
+		// Fill in the rest around the street type
+		if( -1 == nStreetTypePos) return( 0);
+		long nRemainder = assignStreetValues( addrComp, copyValue, allTokens, nTokens, nStreetTypePos);
+		INSTRUMENT_LAP( PS_ASSEMBLY);
 
-			// Extract street number
-			long streetNumber = -1;
-			if( 1 != sscanf( allTokens.front(), "%ld", &streetNumber)) streetNumber = -1;
+		// Need to look right for a unit number?
+		if( 0x0 == acUnitType[0]) {
 
-			// Is there a pre-directional?
-			unsigned long nStreetNameTo = nStreetTypePos - 1;
-			char *pToken = allTokens[nStreetTypePos - 1];
-			for( int nPos = 0; (const char *) 0x0 != addressCompression::KNOWN_DIRECTIONALS[nPos]; ++ nPos) {
-				if( 0x0 == strcmp( pToken, addressCompression::KNOWN_DIRECTIONALS[nPos])) {
-					strncpy( acPreDirectional, pToken, (sizeof(acPreDirectional) / sizeof( acPreDirectional[0])) - 1);
-					-- nStreetNameTo;
+			long nUnitTypePos = -1;
+			for( long nPos = nStreetTypePos + 1; nTokens > nPos; ++ nPos) {
+				const S_TOKEN &token = allTokens[nPos];
+				const char *pText = copyValue + token.offset;
+				if( 0 != (TOKEN_HASH_ONLY & token.flags)) {
+					nUnitTypePos = nPos;
+					strncpy( acUnitType, "UNIT", (sizeof( acUnitType) / sizeof( acUnitType[0])) - 1);
+					nRemainder = nPos + 1;
 					break;
 				}
-			}
-
-			// Pull the street name
-			unsigned long nStreetNameFrom = ((-1 == streetNumber) ? 0 : 1);
-			if( -1 != nUnitTypePos) nStreetNameFrom = nUnitTypePos + 2;
-			size_t nameLen = 0;
-			for( unsigned long nPos = nStreetNameFrom; nStreetNameTo >= nPos; ++ nPos) {
-				pToken = allTokens[nPos];
-				strncat( acStreetName, pToken, (sizeof( acStreetName) / sizeof( acStreetName[0])) - nameLen - 2);
-				strcat( acStreetName, " ");
-				nameLen += strlen( pToken) + 1;
-			}
-
-			// A pre-directional with no street name means the pre-directional IS the street name
-			if( (0x0 != acPreDirectional[0]) && (0x0 == acStreetName[0])) {
-				strncpy( acStreetName, acPreDirectional, sizeof( acStreetName) - 1);
-				memset( acPreDirectional, 0x0, sizeof( acPreDirectional));
-			}
-
-			// Have a street number?
-			if( -1 != streetNumber) {
-				strncpy( acStreetNum, allTokens[0], (sizeof( acStreetNum) / sizeof(acStreetNum[0])) - 1);
-			}
-
-			// Is there a post directional?
-			if( allTokens.size() > (nStreetTypePos + 1)) {
-				pToken = allTokens[nStreetTypePos + 1];
-				for( int nPos = 0; (const char *) 0x0 != addressCompression::KNOWN_DIRECTIONALS[nPos]; ++ nPos) {
-					if( 0x0 == strcmp( pToken, addressCompression::KNOWN_DIRECTIONALS[nPos])) {
-						strncpy( acPostDirectional, pToken, (sizeof(acPostDirectional) / sizeof( acPostDirectional[0])) - 1);
-						++ nRemainder;
-						break;
-					}
+				else if( 0 != (TOKEN_HASH_START & token.flags)) {
+					strncpy( acUnitType, "UNIT", (sizeof( acUnitType) / sizeof( acUnitType[0])) - 1);
+					strncpy( acUnitNumber, pText + 1, (sizeof( acUnitNumber) / sizeof( acUnitNumber[0])) - 1);
+					nRemainder = nPos + 1;
+					break;
+				}
+				else if( (const S_CONVERSION_TYPE *) 0x0 != addrComp.lookupUnitType( pText, token.length)) {
+					nRemainder = nPos + 1;
+					nUnitTypePos = nPos;
+					strncpy( acUnitType, pText, (sizeof( acUnitType) / sizeof( acUnitType[0])) - 1);
+					break;
 				}
 			}
 
-			// Need to look right for a unit number?
-			if( 0x0 == acUnitType[0]) {
-
-				for( unsigned long nPos = nStreetTypePos + 1; allTokens.size() > nPos; ++ nPos) {
-					pToken = allTokens[nPos];
-					S_CONVERSION_TYPE *ctNode = addrComp.lookupUnitType( pToken);
-					if( 0x0 == strcmp( pToken, "#")) {
-						nUnitTypePos = nPos;
-						strncpy( acUnitType, "UNIT", (sizeof( acUnitType) / sizeof( acUnitType[0])) - 1);
-						nRemainder = nPos + 1;
-						break;
-					}
-					else if( '#' == pToken[0]) {
-						strncpy( acUnitType, "UNIT", (sizeof( acUnitType) / sizeof( acUnitType[0])) - 1);
-						strncpy( acUnitNumber, pToken + 1, (sizeof( acUnitNumber) / sizeof( acUnitNumber[0])) - 1);
-						nRemainder = nPos + 1;
-						break;
-					}
-					else if( (S_CONVERSION_TYPE *) 0x0 != ctNode) {
+			// None spelled right - the nearest misspelling past the post-directional, if asked
+			if( (0x0 == acUnitType[0]) && (0 != scratch.maxEditDistance)) {
+				for( long nPos = nRemainder; nTokens > nPos; ++ nPos) {
+					const S_CONVERSION_TYPE *ctNode = addrComp.lookupUnitTypeFuzzy( copyValue + allTokens[nPos].offset, allTokens[nPos].length, scratch.maxEditDistance);
+					if( (const S_CONVERSION_TYPE *) 0x0 != ctNode) {
 						nRemainder = nPos + 1;
 						nUnitTypePos = nPos;
-						strncpy( acUnitType, pToken, (sizeof( acUnitType) / sizeof( acUnitType[0])) - 1);
+						strncpy( acUnitType, ctNode->type, (sizeof( acUnitType) / sizeof( acUnitType[0])) - 1);
 						break;
 					}
 				}
-				if( (-1 != nUnitTypePos) && (allTokens.size() > (nUnitTypePos + 1))){
-					char *pToken = allTokens[nUnitTypePos + 1];
-					strncpy( acUnitNumber, pToken, (sizeof( acUnitNumber) / sizeof( acUnitNumber[0])) - 1);
-					++ nRemainder;
-				}
+			}
+			if( (-1 != nUnitTypePos) && (nTokens > (nUnitTypePos + 1))) {
+				strncpy( acUnitNumber, copyValue + allTokens[nUnitTypePos + 1].offset, (sizeof( acUnitNumber) / sizeof( acUnitNumber[0])) - 1);
+				++ nRemainder;
+			}
+			if( 0x0 != acUnitType[0]) INSTRUMENT_COUNT( PB_UNIT_AFTER_STREET);
+			INSTRUMENT_LAP( PS_UNIT_SCAN);
 
-			} // endif look for unit type
+		} // endif look for unit type
 
-		} // endif found street type
+		return( nRemainder);
 
-		// Capture the remainder
-		size_t remainderLen = 0;
-		for( unsigned long nPos = nRemainder; allTokens.size() > nPos; ++ nPos) {
-			char *pToken = allTokens[nPos];
-			strncat( acRemainder, pToken, (sizeof( acRemainder) / sizeof( acRemainder[0])) - remainderLen - allTokens.size());
-			strcat( acRemainder, " ");
-			remainderLen += strlen( pToken) + 1;
+	}
+
+	// Fill in the number, directionals and name around a found street type
+	long deliveryLine::assignStreetValues( const addressCompression &addrComp, const char *copyValue, const S_TOKEN *allTokens, const long nTokens, const long nStreetTypePos) {
+
+		long nRemainder = nStreetTypePos + 1;
+
+		// Extract street number
+		const long nFirstToken = nextLiveToken( allTokens, nTokens, -1);
+		const bool hasNumber = (nStreetTypePos > nFirstToken) && (0 != (TOKEN_NUMERIC_START & allTokens[nFirstToken].flags));
+
+		// Is there a pre-directional?
+		long nStreetNameTo = prevLiveToken( allTokens, nStreetTypePos);
+		if( 0 <= nStreetNameTo) {
+			const char *pText = copyValue + allTokens[nStreetNameTo].offset;
+			if( addrComp.isDirectional( pText, allTokens[nStreetNameTo].length)) {
+				strncpy( acPreDirectional, pText, (sizeof(acPreDirectional) / sizeof( acPreDirectional[0])) - 1);
+				nStreetNameTo = prevLiveToken( allTokens, nStreetNameTo);
+			}
 		}
-		acRemainder[remainderLen - 1] = 0x0;
 
-		// Trim the street name
-		for( size_t nPos = strlen( acStreetName) - 1; (0 < nPos) && (' ' == acStreetName[nPos]); --nPos)
-			acStreetName[nPos] = 0x0;
+		// Pull the street name
+		const long nStreetNameFrom = hasNumber ? nextLiveToken( allTokens, nTokens, nFirstToken) : nFirstToken;
+		size_t nameLen = 0;
+		for( long nPos = nStreetNameFrom; nStreetNameTo >= nPos; nPos = nextLiveToken( allTokens, nTokens, nPos)) {
+			if( ! appendToken( acStreetName, sizeof( acStreetName), nameLen, copyValue + allTokens[nPos].offset, allTokens[nPos].length)) break;
+		}
 
-		// Fix for numbered streets (like state highways)
-		if( (0x0 == acPostDirectional[0]) && (0x0 == acUnitType[0]) && (0x0 == acUnitNumber[0]) && (0x0 != acRemainder[0])) {
+		// A pre-directional with no street name means the pre-directional IS the street name
+		if( (0x0 != acPreDirectional[0]) && (0x0 == acStreetName[0])) {
+			strncpy( acStreetName, acPreDirectional, sizeof( acStreetName) - 1);
+			acPreDirectional[0] = 0x0;
+		}
 
-			bool allNumbers = true;
-			for( size_t nPos = 0; 0x0 != acRemainder[nPos]; ++ nPos) {
-				allNumbers &= (isdigit( acRemainder[nPos]) || isspace( acRemainder[nPos]));
+		// Have a street number?
+		if( hasNumber) {
+			strncpy( acStreetNum, copyValue + allTokens[nFirstToken].offset, (sizeof( acStreetNum) / sizeof(acStreetNum[0])) - 1);
+		}
+
+		// Is there a post directional?
+		if( nTokens > (nStreetTypePos + 1)) {
+			const char *pText = copyValue + allTokens[nStreetTypePos + 1].offset;
+			if( addrComp.isDirectional( pText, allTokens[nStreetTypePos + 1].length)) {
+				strncpy( acPostDirectional, pText, (sizeof(acPostDirectional) / sizeof( acPostDirectional[0])) - 1);
+				++ nRemainder;
 			}
-			if( allNumbers) {
-				char newValue[4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
-				sprintf( newValue, "%s %s %s", acStreetName, acStreetType, acRemainder);
-				memset( acStreetName, 0x0, sizeof( acStreetName));
-				memset( acStreetType, 0x0, sizeof( acStreetType));
-				memset( acRemainder, 0x0, sizeof( acRemainder));
-				strncpy( acStreetName, newValue, MAX_DELIVERY_LINE_ELEMENT_SIZE);
+		}
+
+		return( nRemainder);
+
+	}
+
+	// Token classes for the street state machine
+	#define	STC_WORD						(0)
+	#define	STC_STREET_TYPE					(1)			// In the street type dictionary, and not one of the first two tokens
+	#define	STC_UNIT_TYPE					(2)			// In the unit type dictionary
+	#define	STC_HASH_ONLY					(3)			// A lone '#'
+	#define	STC_HASH_START					(4)			// '#' and the unit number
+	#define	STC_COUNT						(5)
+
+	// States - the tokens are read right to left
+	#define	STS_AFTER_TYPE					(0)			// No street type yet
+	#define	STS_BEFORE_TYPE					(1)			// Left of the street type, looking for a unit
+	#define	STS_DONE						(2)
+	#define	STS_COUNT						(3)
+
+	// Actions on a transition
+	#define	STA_NONE						(0)
+	#define	STA_STREET_TYPE					(1)			// This is the street type
+	#define	STA_RIGHT_UNIT					(2)			// The nearest unit right of the street type so far
+	#define	STA_LEFT_UNIT					(3)			// The unit left of the street type
+
+	// Dictionaries a state needs to classify a token
+	#define	STL_STREET_TYPES				(0x01)
+	#define	STL_UNIT_TYPES					(0x02)
+
+	// One transition
+	struct s_street_transition {
+		uint8_t nextState;
+		uint8_t action;
+	};
+	typedef struct s_street_transition S_STREET_TRANSITION;
+
+	// The state table - indexed by state, then token class
+	static constexpr S_STREET_TRANSITION STREET_MACHINE [STS_COUNT][STC_COUNT] = {
+		// Word								Street type							Unit type							Lone '#'							'#' and number
+		{ { STS_AFTER_TYPE, STA_NONE },		{ STS_BEFORE_TYPE, STA_STREET_TYPE },	{ STS_AFTER_TYPE, STA_RIGHT_UNIT },	{ STS_AFTER_TYPE, STA_RIGHT_UNIT },	{ STS_AFTER_TYPE, STA_RIGHT_UNIT } },
+		{ { STS_BEFORE_TYPE, STA_NONE },	{ STS_BEFORE_TYPE, STA_NONE },		{ STS_DONE, STA_LEFT_UNIT },		{ STS_DONE, STA_LEFT_UNIT },		{ STS_DONE, STA_LEFT_UNIT } },
+		{ { STS_DONE, STA_NONE },			{ STS_DONE, STA_NONE },				{ STS_DONE, STA_NONE },				{ STS_DONE, STA_NONE },				{ STS_DONE, STA_NONE } }
+	};
+	static constexpr uint8_t STREET_MACHINE_LOOKUPS [STS_COUNT] = { STL_STREET_TYPES | STL_UNIT_TYPES, STL_UNIT_TYPES, 0 };
+
+	// Class of one token - only the dictionaries the state needs are read
+	// No street or unit type starts with a digit, so numbers are never looked up
+	static inline uint8_t classifyStreetToken( const addressCompression &addrComp, const char *copyValue, const S_TOKEN &token, const long nToken, const uint8_t lookups, const S_CONVERSION_TYPE *&ctStreetType) {
+		if( 0 != (TOKEN_HASH_ONLY & token.flags)) return( STC_HASH_ONLY);
+		if( 0 != (TOKEN_HASH_START & token.flags)) return( STC_HASH_START);
+		if( 0 != (TOKEN_NUMERIC_START & token.flags)) return( STC_WORD);
+		if( (0 != (STL_STREET_TYPES & lookups)) && (1 < nToken)) {
+			ctStreetType = addrComp.lookupStreetType( copyValue + token.offset, token.length);
+			if( (const S_CONVERSION_TYPE *) 0x0 != ctStreetType) return( STC_STREET_TYPE);
+		}
+		if( (0 != (STL_UNIT_TYPES & lookups)) && ((const S_CONVERSION_TYPE *) 0x0 != addrComp.lookupUnitType( copyValue + token.offset, token.length))) return( STC_UNIT_TYPE);
+		return( STC_WORD);
+	}
+
+	//
+	// Find the street components with the state table
+	//
+	// One right to left pass classifies each token and steps the table,
+	// noting where the street type and the units on either side of it
+	// are.  The first street type met is the rightmost one; the last unit
+	// met before it is the nearest one on its right, and the first one
+	// met after it is the nearest one on its left, which ends the pass.
+	//
+	long deliveryLine::parseStreetMachine( S_PARSE_SCRATCH &scratch, S_TOKEN *allTokens, const long nTokens) {
+
+		// Dictionary lookups
+		const addressCompression addrComp( scratch.pDictionary);
+		char *copyValue = scratch.copyValue;
+
+		// Run the table
+		const S_CONVERSION_TYPE *ctStreetType = (const S_CONVERSION_TYPE *) 0x0;
+		long nStreetTypePos = -1, nRightUnitPos = -1, nLeftUnitPos = -1;
+		uint8_t rightUnitClass = STC_WORD, leftUnitClass = STC_WORD;
+		uint8_t nState = STS_AFTER_TYPE;
+		for( long nToken = nTokens - 1; (0 <= nToken) && (STS_DONE != nState); -- nToken) {
+			const S_CONVERSION_TYPE *ctFound = (const S_CONVERSION_TYPE *) 0x0;
+			const uint8_t tokenClass = classifyStreetToken( addrComp, copyValue, allTokens[nToken], nToken, STREET_MACHINE_LOOKUPS[nState], ctFound);
+			const S_STREET_TRANSITION &transition = STREET_MACHINE[nState][tokenClass];
+			switch( transition.action) {
+				case STA_STREET_TYPE: nStreetTypePos = nToken; ctStreetType = ctFound; break;
+				case STA_RIGHT_UNIT: nRightUnitPos = nToken; rightUnitClass = tokenClass; break;
+				case STA_LEFT_UNIT: nLeftUnitPos = nToken; leftUnitClass = tokenClass; break;
+				default: break;
 			}
+			nState = transition.nextState;
+		}
+		INSTRUMENT_LAP( PS_STREET_TYPE_SCAN);
+
+		// No street type leaves everything to the remainder
+		if( -1 == nStreetTypePos) return( 0);
+		strncpy( acStreetType, ctStreetType->preftype, (sizeof( acStreetType) / sizeof( acStreetType[0])) - 1);
+
+		// A unit on the left is taken out of the name
+		// The street type itself is never taken as the unit number
+		if( -1 != nLeftUnitPos) {
+			INSTRUMENT_COUNT( PB_UNIT_BEFORE_STREET);
+			const char *pText = copyValue + allTokens[nLeftUnitPos].offset;
+			strncpy( acUnitType, (STC_UNIT_TYPE == leftUnitClass) ? pText : "UNIT", (sizeof( acUnitType) / sizeof( acUnitType[0])) - 1);
+			if( STC_HASH_START == leftUnitClass) {
+				strncpy( acUnitNumber, pText + 1, (sizeof( acUnitNumber) / sizeof( acUnitNumber[0])) - 1);
+			}
+			else if( nStreetTypePos > (nLeftUnitPos + 1)) {
+				strncpy( acUnitNumber, copyValue + allTokens[nLeftUnitPos + 1].offset, (sizeof( acUnitNumber) / sizeof( acUnitNumber[0])) - 1);
+				allTokens[nLeftUnitPos + 1].flags |= TOKEN_REMOVED;
+			}
+			allTokens[nLeftUnitPos].flags |= TOKEN_REMOVED;
+		}
 
+		// Fill in the rest around the street type
+		long nRemainder = assignStreetValues( addrComp, copyValue, allTokens, nTokens, nStreetTypePos);
+
+		// Otherwise take the unit on the right
+		if( (-1 == nLeftUnitPos) && (-1 != nRightUnitPos)) {
+			INSTRUMENT_COUNT( PB_UNIT_AFTER_STREET);
+			const char *pText = copyValue + allTokens[nRightUnitPos].offset;
+			strncpy( acUnitType, (STC_UNIT_TYPE == rightUnitClass) ? pText : "UNIT", (sizeof( acUnitType) / sizeof( acUnitType[0])) - 1);
+			nRemainder = nRightUnitPos + 1;
+			if( STC_HASH_START == rightUnitClass) {
+				strncpy( acUnitNumber, pText + 1, (sizeof( acUnitNumber) / sizeof( acUnitNumber[0])) - 1);
+			}
+			else if( nTokens > nRemainder) {
+				strncpy( acUnitNumber, copyValue + allTokens[nRemainder].offset, (sizeof( acUnitNumber) / sizeof( acUnitNumber[0])) - 1);
+				++ nRemainder;
+			}
 		}
 
+		return( nRemainder);
+
 	}
 
 	// Destruct a delivery line
@@ -1116,6 +1848,338 @@ namespace libAddr {
 
 	}
 
+	// Construct an empty view
+	deliveryLineView::deliveryLineView() {
+		pText = pStreetType = pUnitType = (const char *) 0x0;
+		memset( componentOffset, 0x0, sizeof( componentOffset));
+		memset( componentLength, 0x0, sizeof( componentLength));
+	}
+
+	// Pack a parsed line into a view
+	size_t deliveryLineView::assign( const deliveryLine &line, char *textBuffer, const size_t textBufferSize, const addressDictionary *pDictionary) {
+
+		const char *allValues [LC_COUNT] = {
+			line.acStreetNum, line.acPreDirectional, line.acStreetName, line.acStreetType, line.acPostDirectional,
+			line.acUnitType, line.acUnitNumber, line.acPOBox, line.acRuralRoute, line.acRemainder
+		};
+
+		// Start empty
+		pText = textBuffer;
+		pStreetType = pUnitType = (const char *) 0x0;
+		memset( componentOffset, 0x0, sizeof( componentOffset));
+		memset( componentLength, 0x0, sizeof( componentLength));
+
+		// Canonical values come from the dictionaries
+		const addressCompression addrComp( pDictionary);
+		const S_CONVERSION_TYPE *ctNode = (0x0 == line.acStreetType[0]) ? (const S_CONVERSION_TYPE *) 0x0 : addrComp.lookupStreetType( line.acStreetType);
+		if( (const S_CONVERSION_TYPE *) 0x0 != ctNode) pStreetType = ctNode->preftype;
+		ctNode = (0x0 == line.acUnitType[0]) ? (const S_CONVERSION_TYPE *) 0x0 : addrComp.lookupUnitType( line.acUnitType);
+		if( (const S_CONVERSION_TYPE *) 0x0 != ctNode) pUnitType = ctNode->type;
+
+		// Pack everything else, each zero terminated
+		size_t nUsed = 0;
+		for( int nComp = 0; LC_COUNT > nComp; ++ nComp) {
+			const size_t valueLen = strlen( allValues[nComp]);
+			componentLength[nComp] = (uint16_t) valueLen;
+			if( (0 == valueLen) || ((LC_STREET_TYPE == nComp) && ((const char *) 0x0 != pStreetType)) || ((LC_UNIT_TYPE == nComp) && ((const char *) 0x0 != pUnitType))) continue;
+			if( ((char *) 0x0 == textBuffer) || (textBufferSize < (nUsed + valueLen + 1))) {
+				*this = deliveryLineView();
+				return( 0);
+			}
+			memcpy( textBuffer + nUsed, allValues[nComp], valueLen + 1);
+			componentOffset[nComp] = (uint16_t) nUsed;
+			nUsed += valueLen + 1;
+		}
+
+		// Never hand back zero for a successful, empty line
+		if( 0 == nUsed) {
+			if( ((char *) 0x0 == textBuffer) || (0 == textBufferSize)) {
+				*this = deliveryLineView();
+				return( 0);
+			}
+			textBuffer[nUsed ++] = 0x0;
+		}
+		return( nUsed);
+
+	}
+
+	// Return a component
+	const char * deliveryLineView::getComponent( const E_LINE_COMPONENT component) const {
+		if( 0 == componentLength[component]) return( "");
+		if( LC_STREET_TYPE == component && ((const char *) 0x0 != pStreetType)) return( pStreetType);
+		if( LC_UNIT_TYPE == component && ((const char *) 0x0 != pUnitType)) return( pUnitType);
+		return( pText + componentOffset[component]);
+	}
+
+	// Construct a reusable parser
+	deliveryLineParser::deliveryLineParser() {
+		scratch.nTokens = 0;
+		scratch.pDictionary = (const addressDictionary *) 0x0;
+		scratch.maxEditDistance = 0;
+		engine = PE_RULES;
+		pDictionaryHandle = (dictionaryHandle *) 0x0;
+		pDictionaryReader = (S_DICTIONARY_READER *) 0x0;
+	}
+
+	// Destruct a reusable parser
+	deliveryLineParser::~deliveryLineParser() {
+		setDictionaryHandle( (dictionaryHandle *) 0x0);
+	}
+
+	// Use a fixed dictionary
+	void deliveryLineParser::setDictionary( const addressDictionary *pDictionary) {
+		setDictionaryHandle( (dictionaryHandle *) 0x0);
+		scratch.pDictionary = pDictionary;
+	}
+
+	// Follow a reloadable handle
+	void deliveryLineParser::setDictionaryHandle( dictionaryHandle *pHandle) {
+		if( (dictionaryHandle *) 0x0 != pDictionaryHandle) pDictionaryHandle->detach( pDictionaryReader);
+		pDictionaryHandle = pHandle;
+		pDictionaryReader = ((dictionaryHandle *) 0x0 == pHandle) ? (S_DICTIONARY_READER *) 0x0 : pHandle->attach();
+		scratch.pDictionary = (const addressDictionary *) 0x0;
+	}
+
+	// Correct misspelled types by up to maxDistance edits
+	void deliveryLineParser::setFuzzyDistance( const int maxDistance) {
+		scratch.maxEditDistance = (0 > maxDistance) ? 0 : ((MAX_FUZZY_DISTANCE < maxDistance) ? MAX_FUZZY_DISTANCE : maxDistance);
+	}
+
+	// Release the version last used
+	void deliveryLineParser::releaseDictionary() {
+		if( (dictionaryHandle *) 0x0 != pDictionaryHandle) pDictionaryHandle->release( pDictionaryReader);
+	}
+
+	// Pick up the current version
+	void deliveryLineParser::enterDictionary() {
+		if( (dictionaryHandle *) 0x0 != pDictionaryHandle) scratch.pDictionary = pDictionaryHandle->enter( pDictionaryReader);
+	}
+
+	// Parse a line into the held result
+	const deliveryLine & deliveryLineParser::parse( const char *inputLine, const size_t inputLen) {
+		enterDictionary();
+		result.parseLine( inputLine, inputLen, scratch, engine);
+		return( result);
+	}
+
+	// Clean a line without parsing it
+	size_t deliveryLineParser::prepare( const char *inputLine, const size_t inputLen) {
+		INSTRUMENT_START();
+		scratch.copyValue[0] = 0x0;
+		scratch.nTokens = 0;
+		if( ((const char *) 0x0 == inputLine) || (0x0 == inputLen) || (0x0 == inputLine[0])) return( 0);
+		prepassInput( inputLine, inputLen, scratch);
+		INSTRUMENT_LAP( PS_PREPASS);
+		return( strlen( scratch.copyValue));
+	}
+
+	// Parse the prepared copy
+	const deliveryLine & deliveryLineParser::parsePrepared() {
+		result.clear();
+		result.parseTokens( scratch, engine);
+		return( result);
+	}
+
+	// Write the normalized line for a parsed result
+	size_t deliveryLineParser::writeNormalized( const deliveryLine &dl, char *outLine, const size_t outLineSize) const {
+		const addressCompression addrComp( scratch.pDictionary);
+		return( writeNormalizedLine( addrComp, dl, outLine, outLineSize));
+	}
+
+	// Parse a line into a compact view
+	size_t deliveryLineParser::parse( const char *inputLine, const size_t inputLen, deliveryLineView &view, char *textBuffer, const size_t textBufferSize) {
+		enterDictionary();
+		result.parseLine( inputLine, inputLen, scratch, engine);
+		return( view.assign( result, textBuffer, textBufferSize, scratch.pDictionary));
+	}
+
+	// Parse an array of lines
+	size_t deliveryLineParser::parseBatch( const char * const *inputLines, const size_t nLines, deliveryLine *results) {
+
+		// Trivial?
+		if( ((const char * const *) 0x0 == inputLines) || ((deliveryLine *) 0x0 == results)) return( 0);
+
+		enterDictionary();
+		for( size_t nLine = 0; nLines > nLine; ++ nLine) {
+			const char *inputLine = inputLines[nLine];
+			const size_t inputLen = ((const char *) 0x0 == inputLine) ? 0 : strnlen( inputLine, MAX_DELIVERY_LINE_ELEMENT_SIZE * 4);
+			results[nLine].parseLine( inputLine, inputLen, scratch, engine);
+		}
+		return( nLines);
+
+	}
+
+	// Parse lines from one buffer
+	size_t deliveryLineParser::parseBatch( const char *buffer, const size_t *lineOffsets, const size_t nLines, deliveryLine *results) {
+
+		// Trivial?
+		if( ((const char *) 0x0 == buffer) || ((const size_t *) 0x0 == lineOffsets) || ((deliveryLine *) 0x0 == results)) return( 0);
+
+		enterDictionary();
+		for( size_t nLine = 0; nLines > nLine; ++ nLine) {
+			const char *inputLine = buffer + lineOffsets[nLine];
+			size_t inputLen = (lineOffsets[nLine + 1] > lineOffsets[nLine]) ? (lineOffsets[nLine + 1] - lineOffsets[nLine]) : 0;
+			while( (0 < inputLen) && (('\n' == inputLine[inputLen - 1]) || ('\r' == inputLine[inputLen - 1]))) -- inputLen;
+			results[nLine].parseLine( inputLine, inputLen, scratch, engine);
+		}
+		return( nLines);
+
+	}
+
+	// Parse an array of lines into columns
+	size_t deliveryLineParser::parseBatch( const char * const *inputLines, const size_t nLines, deliveryLineColumns &columns) {
+
+		// Trivial?
+		if( (const char * const *) 0x0 == inputLines) return( 0);
+
+		enterDictionary();
+		columns.reserve( nLines);
+		for( size_t nLine = 0; nLines > nLine; ++ nLine) {
+			const char *inputLine = inputLines[nLine];
+			const size_t inputLen = ((const char *) 0x0 == inputLine) ? 0 : strnlen( inputLine, MAX_DELIVERY_LINE_ELEMENT_SIZE * 4);
+			result.parseLine( inputLine, inputLen, scratch, engine);
+			if( ! columns.append( result)) return( nLine);
+		}
+		return( nLines);
+
+	}
+
+	// Parse lines from one buffer into columns
+	size_t deliveryLineParser::parseBatch( const char *buffer, const size_t *lineOffsets, const size_t nLines, deliveryLineColumns &columns) {
+
+		// Trivial?
+		if( ((const char *) 0x0 == buffer) || ((const size_t *) 0x0 == lineOffsets)) return( 0);
+
+		enterDictionary();
+		columns.reserve( nLines);
+		for( size_t nLine = 0; nLines > nLine; ++ nLine) {
+			const char *inputLine = buffer + lineOffsets[nLine];
+			size_t inputLen = (lineOffsets[nLine + 1] > lineOffsets[nLine]) ? (lineOffsets[nLine + 1] - lineOffsets[nLine]) : 0;
+			while( (0 < inputLen) && (('\n' == inputLine[inputLen - 1]) || ('\r' == inputLine[inputLen - 1]))) -- inputLen;
+			result.parseLine( inputLine, inputLen, scratch, engine);
+			if( ! columns.append( result)) return( nLine);
+		}
+		return( nLines);
+
+	}
+
+	// A distinct line within a batch
+	struct s_batch_slot {
+		uint64_t hash;
+		size_t keyOffset;						// Start of the cleaned copy in the key pool
+		size_t keyLen;
+		size_t firstLine;						// The first line with this key - BATCH_EMPTY if unused
+		size_t normalizedLen;					// Length written for it - BATCH_UNCHANGED if copied as is
+	};
+	typedef struct s_batch_slot S_BATCH_SLOT;
+
+	#define	BATCH_EMPTY						((size_t) -1)
+	#define	BATCH_UNCHANGED					((size_t) -1)
+
+	// Normalize an array of lines, once per distinct line
+	size_t deliveryLineParser::normalizeBatch( const char * const *inputLines, const size_t nLines, char *outputLines, const size_t outputLineSize, size_t *outputLengths) {
+
+		// Trivial?
+		if( ((const char * const *) 0x0 == inputLines) || ((char *) 0x0 == outputLines) || (0x0 == outputLineSize)) return( 0);
+
+		// Two indexes at most half full - exact input bytes, then the cleaned copy - and room for the keys
+		// Exact repeats are found without cleaning the line at all
+		size_t nSlots = 16;
+		while( nSlots < (2 * nLines)) nSlots <<= 1;
+		S_BATCH_SLOT emptySlot = { 0, 0, 0, BATCH_EMPTY, 0 };
+		std::vector< S_BATCH_SLOT> exactSlots( nSlots, emptySlot);
+		std::vector< S_BATCH_SLOT> cleanSlots( nSlots, emptySlot);
+		std::vector< char> keyPool;
+		keyPool.reserve( 32 * nLines);
+
+		enterDictionary();
+		const addressCompression addrComp( scratch.pDictionary);
+		size_t nDistinct = 0;
+		for( size_t nLine = 0; nLines > nLine; ++ nLine) {
+
+			// Lines as is are copied up to the output size, but only cleaned up to the parse limit
+			const char *inputLine = ((const char *) 0x0 == inputLines[nLine]) ? "" : inputLines[nLine];
+			const size_t exactLen = strnlen( inputLine, (outputLineSize > (MAX_DELIVERY_LINE_ELEMENT_SIZE * 4)) ? (outputLineSize - 1) : (MAX_DELIVERY_LINE_ELEMENT_SIZE * 4));
+			const size_t inputLen = (exactLen < (MAX_DELIVERY_LINE_ELEMENT_SIZE * 4)) ? exactLen : (MAX_DELIVERY_LINE_ELEMENT_SIZE * 4);
+			const size_t copyLen = (exactLen < outputLineSize) ? exactLen : (outputLineSize - 1);
+			char *outLine = outputLines + nLine * outputLineSize;
+			size_t outLen = 0;
+
+			// The same bytes as an earlier line?  A null line is read as empty here too
+			const uint64_t exactHash = hashDictionaryKey( inputLine, exactLen);
+			size_t nExact = exactHash & (nSlots - 1);
+			while( BATCH_EMPTY != exactSlots[nExact].firstLine) {
+				const S_BATCH_SLOT &slot = exactSlots[nExact];
+				const char *slotLine = ((const char *) 0x0 == inputLines[slot.firstLine]) ? "" : inputLines[slot.firstLine];
+				if( (exactHash == slot.hash) && (exactLen == slot.keyLen) && (0x0 == memcmp( inputLine, slotLine, exactLen))) break;
+				nExact = (nExact + 1) & (nSlots - 1);
+			}
+			S_BATCH_SLOT &exactSlot = exactSlots[nExact];
+			if( BATCH_EMPTY != exactSlot.firstLine) {
+				memcpy( outLine, outputLines + exactSlot.firstLine * outputLineSize, exactSlot.normalizedLen + 1);
+				if( (size_t *) 0x0 != outputLengths) outputLengths[nLine] = exactSlot.normalizedLen;
+				continue;
+			}
+
+			// Clean the line - that is the key
+			const size_t keyLen = prepare( inputLine, inputLen);
+			size_t nClean = BATCH_EMPTY;
+			uint64_t cleanHash = 0;
+			if( 0 != keyLen) {
+				cleanHash = hashDictionaryKey( scratch.copyValue, keyLen);
+				nClean = cleanHash & (nSlots - 1);
+				while( BATCH_EMPTY != cleanSlots[nClean].firstLine) {
+					const S_BATCH_SLOT &slot = cleanSlots[nClean];
+					if( (cleanHash == slot.hash) && (keyLen == slot.keyLen) && (0x0 == memcmp( scratch.copyValue, keyPool.data() + slot.keyOffset, keyLen))) break;
+					nClean = (nClean + 1) & (nSlots - 1);
+				}
+			}
+
+			// Nothing to clean, no street name or a repeat once cleaned
+			if( (BATCH_EMPTY != nClean) && (BATCH_EMPTY != cleanSlots[nClean].firstLine) && (BATCH_UNCHANGED != cleanSlots[nClean].normalizedLen)) {
+				outLen = cleanSlots[nClean].normalizedLen;
+				memcpy( outLine, outputLines + cleanSlots[nClean].firstLine * outputLineSize, outLen);
+				outLine[outLen] = 0x0;
+			}
+			else if( (BATCH_EMPTY == nClean) || (BATCH_EMPTY != cleanSlots[nClean].firstLine)) {
+				outLen = copyLen;
+				memcpy( outLine, inputLine, outLen);
+				outLine[outLen] = 0x0;
+			}
+
+			// A new line - keep the key before parsing cuts the copy up
+			else {
+				S_BATCH_SLOT &slot = cleanSlots[nClean];
+				slot.hash = cleanHash;
+				slot.keyOffset = keyPool.size();
+				slot.keyLen = keyLen;
+				slot.firstLine = nLine;
+				keyPool.insert( keyPool.end(), scratch.copyValue, scratch.copyValue + keyLen);
+				++ nDistinct;
+				const deliveryLine &dl = parsePrepared();
+				if( 0x0 == dl.getStreetName()[0]) {
+					slot.normalizedLen = BATCH_UNCHANGED;
+					outLen = copyLen;
+					memcpy( outLine, inputLine, outLen);
+					outLine[outLen] = 0x0;
+				}
+				else {
+					outLen = slot.normalizedLen = writeNormalizedLine( addrComp, dl, outLine, outputLineSize);
+				}
+			}
+			if( (size_t *) 0x0 != outputLengths) outputLengths[nLine] = outLen;
+
+			// Later copies of these exact bytes take this output
+			exactSlot.hash = exactHash;
+			exactSlot.keyLen = exactLen;
+			exactSlot.firstLine = nLine;
+			exactSlot.normalizedLen = outLen;
+
+		}
+		return( nDistinct);
+
+	}
+
 	// Debug dump
 	void deliveryLine::debugDump( FILE *fOutput) {
 
@@ -1130,5 +2194,66 @@ namespace libAddr {
 
 	}
 
+	// Were parse statistics compiled in?
+	bool deliveryLine::isInstrumented() {
+#if defined( LIBADDR_INSTRUMENT)
+		return( true);
+#else
+		return( false);
+#endif
+	}
+
+	// Read the parse statistics of every thread
+	void deliveryLine::getStatistics( S_PARSE_STATISTICS &statistics) {
+		memset( &statistics, 0x0, sizeof( statistics));
+#if defined( LIBADDR_INSTRUMENT)
+		uint64_t allCounts [STAT_COUNT];
+		sumStatistics( allCounts);
+		statistics.lines = allCounts[STAT_LINES];
+		for( int nBranch = 0; PB_COUNT > nBranch; ++ nBranch) statistics.branches[nBranch] = allCounts[STAT_BRANCH( nBranch)];
+		for( int nStage = 0; PS_COUNT > nStage; ++ nStage) {
+			statistics.stageCalls[nStage] = allCounts[STAT_CALLS( nStage)];
+			statistics.stageTicks[nStage] = allCounts[STAT_TICKS( nStage)];
+		}
+#endif
+	}
+
+	// Start the parse statistics over - the counts so far become the baseline
+	void deliveryLine::resetStatistics() {
+#if defined( LIBADDR_INSTRUMENT)
+		uint64_t allCounts [STAT_COUNT];
+		sumStatistics( allCounts);
+		S_STATISTICS_REGISTRY &registry = statisticsRegistry();
+		std::lock_guard< std::mutex> lock( registry.lock);
+		for( int nStat = 0; STAT_COUNT > nStat; ++ nStat) registry.baselineCounts[nStat] += allCounts[nStat];
+#endif
+	}
+
+	// Statistics output dump
+	void deliveryLine::statisticsDump( FILE *fOutput) {
+
+		const char *BRANCH_NAMES [PB_COUNT] = { "PO box:", "Rural route:", "Street type:", "Unit before:", "Unit after:", "Numbered highway:", "Remainder only:" };
+		const char *STAGE_NAMES [PS_COUNT] = { "Pre-pass:", "Header match:", "Tokenize:", "Street type scan:", "Unit scan:", "Assembly:" };
+		if( ! isInstrumented()) {
+			fprintf( fOutput, "Statistics:       ~not compiled in - build with LIBADDR_INSTRUMENT~\n");
+			return;
+		}
+
+		S_PARSE_STATISTICS statistics;
+		getStatistics( statistics);
+		const double lines = (0 == statistics.lines) ? 1.0 : (double) statistics.lines;
+		fprintf( fOutput, "Lines parsed:      %llu\n", (unsigned long long) statistics.lines);
+		for( int nBranch = 0; PB_COUNT > nBranch; ++ nBranch) {
+			fprintf( fOutput, "%-18s %llu (%.1f%%)\n", BRANCH_NAMES[nBranch], (unsigned long long) statistics.branches[nBranch], 100.0 * (double) statistics.branches[nBranch] / lines);
+		}
+		uint64_t totalTicks = 0;
+		for( int nStage = 0; PS_COUNT > nStage; ++ nStage) totalTicks += statistics.stageTicks[nStage];
+		for( int nStage = 0; PS_COUNT > nStage; ++ nStage) {
+			fprintf( fOutput, "%-18s %llu calls, %.1f ticks per line (%.1f%%)\n", STAGE_NAMES[nStage], (unsigned long long) statistics.stageCalls[nStage],
+				(double) statistics.stageTicks[nStage] / lines, (0 == totalTicks) ? 0.0 : (100.0 * (double) statistics.stageTicks[nStage] / (double) totalTicks));
+		}
+
+	}
+
 }
 
@@ -0,0 +1,193 @@
+//
+//  libAddrArena.cpp
+//  libAddr
+//
+//  Packed bulk storage for many parse results.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+// Standard includes
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// STL includes
+#include <vector>
+
+// Project includes
+#include <libAddr.hpp>
+#include <libAddrArena.hpp>
+
+namespace libAddr {
+
+	// Smallest block - holds any record
+	#define	ARENA_MIN_BLOCK					(4096)
+
+	//
+	// A record is, two byte aligned:
+	//
+	//		uint16_t presentMask				Bit per E_LINE_COMPONENT with text
+	//		uint16_t textEnd [nPresent]			End of each such component's text, past its terminator
+	//		char text []						The components, each zero terminated
+	//
+
+	// Where a record's text starts
+	static inline const char * recordText( const uint8_t *pRecord, const uint16_t presentMask) {
+		return( (const char *) pRecord + sizeof( uint16_t) * (1 + __builtin_popcount( presentMask)));
+	}
+
+	/////// Class deliveryLineArena functions ///////
+
+	// Construction
+	deliveryLineArena::deliveryLineArena( const size_t useBlockSize) {
+		blockSize = (ARENA_MIN_BLOCK > useBlockSize) ? ARENA_MIN_BLOCK : useBlockSize;
+		nBlockUsed = 0;
+	}
+
+	// Destruction
+	deliveryLineArena::~deliveryLineArena() {
+		clear();
+	}
+
+	// Add a parsed line
+	bool deliveryLineArena::append( const deliveryLine &line) {
+
+		const char *allValues [LC_COUNT] = {
+			line.getStreetNumber(), line.getPreDirectional(), line.getStreetName(), line.getStreetType(), line.getPostDirectional(),
+			line.getUnitType(), line.getUnitNumber(), line.getPOBox(), line.getRuralRoute(), line.getRemainder()
+		};
+
+		// Size the record
+		size_t allLengths [LC_COUNT];
+		uint16_t presentMask = 0;
+		size_t nPresent = 0;
+		size_t textSize = 0;
+		for( int nComp = 0; LC_COUNT > nComp; ++ nComp) {
+			allLengths[nComp] = strlen( allValues[nComp]);
+			if( 0 == allLengths[nComp]) continue;
+			presentMask |= (uint16_t) (1 << nComp);
+			textSize += allLengths[nComp] + 1;
+			++ nPresent;
+		}
+		const size_t recordSize = (sizeof( uint16_t) * (1 + nPresent) + textSize + 1) & ~((size_t) 1);
+
+		// Start a block if this one is full
+		if( allBlocks.empty() || (blockSize < (nBlockUsed + recordSize))) {
+			uint8_t *pBlock = (uint8_t *) malloc( blockSize);
+			if( (uint8_t *) 0x0 == pBlock) return( false);
+			allBlocks.push_back( pBlock);
+			nBlockUsed = 0;
+		}
+
+		// Write it
+		uint8_t *pRecord = allBlocks.back() + nBlockUsed;
+		uint16_t *pTextEnd = (uint16_t *) pRecord;
+		*pTextEnd ++ = presentMask;
+		char *pText = (char *) pRecord + sizeof( uint16_t) * (1 + nPresent);
+		size_t nText = 0;
+		for( int nComp = 0; LC_COUNT > nComp; ++ nComp) {
+			if( 0 == allLengths[nComp]) continue;
+			memcpy( pText + nText, allValues[nComp], allLengths[nComp] + 1);
+			nText += allLengths[nComp] + 1;
+			*pTextEnd ++ = (uint16_t) nText;
+		}
+		nBlockUsed += recordSize;
+		allRecords.push_back( pRecord);
+		return( true);
+
+	}
+
+	// Parse a line and add the result
+	bool deliveryLineArena::append( deliveryLineParser &parser, const char *inputLine, const size_t inputLen) {
+		return( append( parser.parse( inputLine, inputLen)));
+	}
+
+	// Find the start of a component in a record
+	const char * deliveryLineArena::findComponent( const uint8_t *pRecord, const E_LINE_COMPONENT component, size_t &componentLen) const {
+		const uint16_t *pHeader = (const uint16_t *) pRecord;
+		const uint16_t presentMask = pHeader[0];
+		componentLen = 0;
+		if( 0 == (presentMask & (1 << component))) return( (const char *) 0x0);
+		const int nBefore = __builtin_popcount( presentMask & ((1 << component) - 1));
+		const uint16_t textStart = (0 == nBefore) ? 0 : pHeader[nBefore];
+		componentLen = pHeader[nBefore + 1] - textStart - 1;
+		return( recordText( pRecord, presentMask) + textStart);
+	}
+
+	// Point a view at a record
+	bool deliveryLineArena::get( const size_t nRecord, deliveryLineView &view) const {
+
+		// Valid?
+		if( allRecords.size() <= nRecord) return( false);
+
+		// Every component is text within the record
+		const uint8_t *pRecord = allRecords[nRecord];
+		const uint16_t *pHeader = (const uint16_t *) pRecord;
+		const uint16_t presentMask = pHeader[0];
+		view.pText = recordText( pRecord, presentMask);
+		view.pStreetType = view.pUnitType = (const char *) 0x0;
+		uint16_t textStart = 0;
+		int nPresent = 0;
+		for( int nComp = 0; LC_COUNT > nComp; ++ nComp) {
+			view.componentOffset[nComp] = 0;
+			view.componentLength[nComp] = 0;
+			if( 0 == (presentMask & (1 << nComp))) continue;
+			const uint16_t textEnd = pHeader[++ nPresent];
+			view.componentOffset[nComp] = textStart;
+			view.componentLength[nComp] = (uint16_t) (textEnd - textStart - 1);
+			textStart = textEnd;
+		}
+		return( true);
+
+	}
+
+	// Return a component of a record
+	const char * deliveryLineArena::getComponent( const size_t nRecord, const E_LINE_COMPONENT component) const {
+		if( allRecords.size() <= nRecord) return( "");
+		size_t componentLen;
+		const char *pComponent = findComponent( allRecords[nRecord], component, componentLen);
+		return( ((const char *) 0x0 == pComponent) ? "" : pComponent);
+	}
+
+	// Memory held
+	size_t deliveryLineArena::getBytesUsed() const {
+		return( allBlocks.size() * blockSize + allBlocks.capacity() * sizeof( uint8_t *) + allRecords.capacity() * sizeof( const uint8_t *));
+	}
+
+	// Free every record
+	void deliveryLineArena::clear() {
+		for( uint8_t *pBlock : allBlocks) free( pBlock);
+		allBlocks.clear();
+		allRecords.clear();
+		nBlockUsed = 0;
+	}
+
+};
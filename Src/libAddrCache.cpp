@@ -0,0 +1,341 @@
+//
+//  libAddrCache.cpp
+//  libAddr
+//
+//  A bounded, thread safe cache of parse and normalize results.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// STL includes
+#include <mutex>
+
+// Project includes
+#include <libAddr.hpp>
+#include <libAddrCache.hpp>
+#include <libAddrHash.hpp>
+
+namespace libAddr {
+
+	// Kinds of cached result
+	#define	CACHE_KIND_PARSE				(0)
+	#define	CACHE_KIND_NORMALIZE			(1)
+
+	// Normalizing leaves the line as it was
+	#define	CACHE_UNCHANGED					(0xFFFF)
+
+	// Average entry size assumed when sizing the index
+	#define	CACHE_AVERAGE_ENTRY				(128)
+
+	// One cached result
+	struct s_cache_entry {
+		struct s_cache_entry *pChain;			// Next entry in the same bucket
+		struct s_cache_entry *pNewer;			// Recency list neighbours
+		struct s_cache_entry *pOlder;
+		uint64_t hash;
+		uint32_t nBytes;						// Size of this allocation
+		uint16_t keyLen;
+		uint16_t kind;
+		uint16_t valueLength [LC_COUNT];		// Component lengths - or the normalized length first
+		char data [1];							// The key, then the value text
+	};
+	typedef struct s_cache_entry S_CACHE_ENTRY;
+
+	// One shard - a lock, a chained index and a recency list
+	struct s_cache_shard {
+		std::mutex shardLock;
+		S_CACHE_ENTRY **allBuckets;
+		size_t nBuckets;
+		S_CACHE_ENTRY *pNewest;
+		S_CACHE_ENTRY *pOldest;
+		size_t bytesUsed;
+		size_t bytesLimit;
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t insertions;
+		uint64_t evictions;
+		uint64_t entries;
+	};
+
+	// Take an entry off the recency list
+	static void unlinkEntry( S_CACHE_SHARD &shard, S_CACHE_ENTRY *pEntry) {
+		if( (S_CACHE_ENTRY *) 0x0 == pEntry->pNewer) shard.pNewest = pEntry->pOlder;
+		else pEntry->pNewer->pOlder = pEntry->pOlder;
+		if( (S_CACHE_ENTRY *) 0x0 == pEntry->pOlder) shard.pOldest = pEntry->pNewer;
+		else pEntry->pOlder->pNewer = pEntry->pNewer;
+	}
+
+	// Put an entry at the new end of the recency list
+	static void pushNewest( S_CACHE_SHARD &shard, S_CACHE_ENTRY *pEntry) {
+		pEntry->pNewer = (S_CACHE_ENTRY *) 0x0;
+		pEntry->pOlder = shard.pNewest;
+		if( (S_CACHE_ENTRY *) 0x0 == shard.pNewest) shard.pOldest = pEntry;
+		else shard.pNewest->pNewer = pEntry;
+		shard.pNewest = pEntry;
+	}
+
+	// Drop the oldest entry
+	static void evictOldest( S_CACHE_SHARD &shard) {
+		S_CACHE_ENTRY *pEntry = shard.pOldest;
+		if( (S_CACHE_ENTRY *) 0x0 == pEntry) return;
+		S_CACHE_ENTRY **ppLink = shard.allBuckets + (pEntry->hash & (shard.nBuckets - 1));
+		while( pEntry != *ppLink) ppLink = &((*ppLink)->pChain);
+		*ppLink = pEntry->pChain;
+		unlinkEntry( shard, pEntry);
+		shard.bytesUsed -= pEntry->nBytes;
+		-- shard.entries;
+		++ shard.evictions;
+		free( pEntry);
+	}
+
+	///////////////////////////////////////
+	// Class deliveryLineCache functions //
+	///////////////////////////////////////
+
+	deliveryLineCache::deliveryLineCache( const size_t cacheBytes, const size_t nWantedShards) : maxBytes( cacheBytes) {
+
+		// A power of two shards
+		nShards = 1;
+		while( nShards < nWantedShards) nShards <<= 1;
+		allShards = new S_CACHE_SHARD [nShards];
+
+		// Split the cap and size each index for it
+		const size_t shardBytes = maxBytes / nShards;
+		for( size_t nShard = 0; nShards > nShard; ++ nShard) {
+			S_CACHE_SHARD &shard = allShards[nShard];
+			shard.nBuckets = 16;
+			while( (shard.nBuckets * CACHE_AVERAGE_ENTRY) < shardBytes) shard.nBuckets <<= 1;
+			shard.allBuckets = (S_CACHE_ENTRY **) calloc( shard.nBuckets, sizeof( S_CACHE_ENTRY *));
+			if( (S_CACHE_ENTRY **) 0x0 == shard.allBuckets) shard.nBuckets = 0;
+			shard.pNewest = shard.pOldest = (S_CACHE_ENTRY *) 0x0;
+			shard.bytesUsed = shard.nBuckets * sizeof( S_CACHE_ENTRY *);
+			shard.bytesLimit = shardBytes;
+			shard.hits = shard.misses = shard.insertions = shard.evictions = shard.entries = 0;
+		}
+
+	}
+
+	deliveryLineCache::~deliveryLineCache() {
+		clear();
+		for( size_t nShard = 0; nShards > nShard; ++ nShard) free( allShards[nShard].allBuckets);
+		delete [] allShards;
+	}
+
+	const deliveryLine & deliveryLineCache::parse( deliveryLineParser &parser, const char *inputLine, const size_t inputLen) {
+
+		// Clean the line - that is the key
+		parser.enterDictionary();
+		const size_t keyLen = parser.prepare( inputLine, inputLen);
+		const char *key = parser.scratch.copyValue;
+		const uint64_t hash = hashDictionaryKey( key, keyLen);
+		if( lookup( CACHE_KIND_PARSE, key, keyLen, hash, &parser.result, (char *) 0x0, 0)) return( parser.result);
+
+		// Parsing cuts the copy up, so keep the key aside
+		char acKey [4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
+		memcpy( acKey, key, keyLen);
+		const deliveryLine &dl = parser.parsePrepared();
+		insert( CACHE_KIND_PARSE, acKey, keyLen, hash, &dl, (const char *) 0x0, 0);
+		return( dl);
+
+	}
+
+	size_t deliveryLineCache::normalizeDeliveryLine( deliveryLineParser &parser, char *addrLine, const size_t allocStringSize) {
+
+		// Trivial?
+		if( (char *) 0x0 == addrLine) return( 0);
+		if( 0x0 == allocStringSize) return( 0);
+		if( 0x0 == addrLine[0]) return( 0);
+
+		// Clean the line - that is the key
+		parser.enterDictionary();
+		const size_t keyLen = parser.prepare( addrLine, strnlen( addrLine, MAX_DELIVERY_LINE_ELEMENT_SIZE * 4));
+		const uint64_t hash = hashDictionaryKey( parser.scratch.copyValue, keyLen);
+		if( lookup( CACHE_KIND_NORMALIZE, parser.scratch.copyValue, keyLen, hash, (deliveryLine *) 0x0, addrLine, allocStringSize)) return( strnlen( addrLine, allocStringSize));
+		char acKey [4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
+		memcpy( acKey, parser.scratch.copyValue, keyLen);
+
+		// No street name leaves the line alone
+		const deliveryLine &dl = parser.parsePrepared();
+		if( 0x0 == dl.getStreetName()[0]) {
+			insert( CACHE_KIND_NORMALIZE, acKey, keyLen, hash, (const deliveryLine *) 0x0, (const char *) 0x0, CACHE_UNCHANGED);
+			return( strnlen( addrLine, allocStringSize));
+		}
+
+		// Otherwise write it straight over the input - the parse holds its own copy
+		// A result that may have been cut short by the buffer is not kept
+		const size_t normalizedLen = parser.writeNormalized( dl, addrLine, allocStringSize);
+		if( (normalizedLen + 1) < allocStringSize) insert( CACHE_KIND_NORMALIZE, acKey, keyLen, hash, (const deliveryLine *) 0x0, addrLine, normalizedLen);
+		return( normalizedLen);
+
+	}
+
+	bool deliveryLineCache::lookup( const int kind, const char *key, const size_t keyLen, const uint64_t hash, deliveryLine *dlOutput, char *addrLine, const size_t allocStringSize) {
+
+		S_CACHE_SHARD &shard = allShards[(hash >> 48) & (nShards - 1)];
+		std::lock_guard< std::mutex> lock( shard.shardLock);
+
+		// Find it
+		S_CACHE_ENTRY *pEntry = (0 == shard.nBuckets) ? (S_CACHE_ENTRY *) 0x0 : shard.allBuckets[hash & (shard.nBuckets - 1)];
+		for( ; (S_CACHE_ENTRY *) 0x0 != pEntry; pEntry = pEntry->pChain) {
+			if( (hash == pEntry->hash) && (kind == pEntry->kind) && (keyLen == pEntry->keyLen) && (0x0 == memcmp( key, pEntry->data, keyLen))) break;
+		}
+		if( (S_CACHE_ENTRY *) 0x0 == pEntry) {
+			++ shard.misses;
+			return( false);
+		}
+		++ shard.hits;
+		unlinkEntry( shard, pEntry);
+		pushNewest( shard, pEntry);
+
+		// Copy the result out
+		const char *pValue = pEntry->data + pEntry->keyLen;
+		if( CACHE_KIND_PARSE == kind) {
+			char *allValues [LC_COUNT] = {
+				dlOutput->acStreetNum, dlOutput->acPreDirectional, dlOutput->acStreetName, dlOutput->acStreetType, dlOutput->acPostDirectional,
+				dlOutput->acUnitType, dlOutput->acUnitNumber, dlOutput->acPOBox, dlOutput->acRuralRoute, dlOutput->acRemainder
+			};
+			for( int nComp = 0; LC_COUNT > nComp; ++ nComp) {
+				memcpy( allValues[nComp], pValue, pEntry->valueLength[nComp]);
+				allValues[nComp][pEntry->valueLength[nComp]] = 0x0;
+				pValue += pEntry->valueLength[nComp];
+			}
+			dlOutput->nNoNumberOffset = -1;
+		}
+		else if( CACHE_UNCHANGED != pEntry->valueLength[0]) {
+			size_t valueLen = pEntry->valueLength[0];
+			if( allocStringSize <= valueLen) valueLen = allocStringSize - 1;
+			memcpy( addrLine, pValue, valueLen);
+			addrLine[valueLen] = 0x0;
+		}
+		return( true);
+
+	}
+
+	void deliveryLineCache::insert( const int kind, const char *key, const size_t keyLen, const uint64_t hash, const deliveryLine *dlInput, const char *normalized, const size_t normalizedLen) {
+
+		// Size the entry
+		const char *allValues [LC_COUNT] = {
+			(const char *) 0x0, (const char *) 0x0, (const char *) 0x0, (const char *) 0x0, (const char *) 0x0,
+			(const char *) 0x0, (const char *) 0x0, (const char *) 0x0, (const char *) 0x0, (const char *) 0x0
+		};
+		uint16_t valueLength [LC_COUNT];
+		memset( valueLength, 0x0, sizeof( valueLength));
+		size_t valueBytes = 0;
+		if( CACHE_KIND_PARSE == kind) {
+			const char *allFields [LC_COUNT] = {
+				dlInput->acStreetNum, dlInput->acPreDirectional, dlInput->acStreetName, dlInput->acStreetType, dlInput->acPostDirectional,
+				dlInput->acUnitType, dlInput->acUnitNumber, dlInput->acPOBox, dlInput->acRuralRoute, dlInput->acRemainder
+			};
+			for( int nComp = 0; LC_COUNT > nComp; ++ nComp) {
+				allValues[nComp] = allFields[nComp];
+				valueLength[nComp] = (uint16_t) strlen( allFields[nComp]);
+				valueBytes += valueLength[nComp];
+			}
+		}
+		else {
+			allValues[0] = normalized;
+			valueLength[0] = (uint16_t) normalizedLen;
+			if( CACHE_UNCHANGED != normalizedLen) valueBytes = normalizedLen;
+		}
+		const size_t entryBytes = offsetof( S_CACHE_ENTRY, data) + keyLen + valueBytes;
+
+		S_CACHE_SHARD &shard = allShards[(hash >> 48) & (nShards - 1)];
+		std::lock_guard< std::mutex> lock( shard.shardLock);
+
+		// Too big to ever fit?
+		if( (0 == shard.nBuckets) || (shard.bytesLimit < (shard.nBuckets * sizeof( S_CACHE_ENTRY *)) + entryBytes)) return;
+
+		// Another thread may have added it meanwhile
+		S_CACHE_ENTRY **ppBucket = shard.allBuckets + (hash & (shard.nBuckets - 1));
+		for( S_CACHE_ENTRY *pEntry = *ppBucket; (S_CACHE_ENTRY *) 0x0 != pEntry; pEntry = pEntry->pChain) {
+			if( (hash == pEntry->hash) && (kind == pEntry->kind) && (keyLen == pEntry->keyLen) && (0x0 == memcmp( key, pEntry->data, keyLen))) return;
+		}
+
+		// Make room
+		while( (shard.bytesLimit < (shard.bytesUsed + entryBytes)) && ((S_CACHE_ENTRY *) 0x0 != shard.pOldest)) evictOldest( shard);
+
+		// Build and link it
+		S_CACHE_ENTRY *pEntry = (S_CACHE_ENTRY *) malloc( entryBytes);
+		if( (S_CACHE_ENTRY *) 0x0 == pEntry) return;
+		pEntry->hash = hash;
+		pEntry->nBytes = (uint32_t) entryBytes;
+		pEntry->keyLen = (uint16_t) keyLen;
+		pEntry->kind = (uint16_t) kind;
+		memcpy( pEntry->valueLength, valueLength, sizeof( valueLength));
+		memcpy( pEntry->data, key, keyLen);
+		char *pValue = pEntry->data + keyLen;
+		for( int nComp = 0; (LC_COUNT > nComp) && ((const char *) 0x0 != allValues[nComp]); ++ nComp) {
+			if( CACHE_UNCHANGED == valueLength[nComp]) break;
+			memcpy( pValue, allValues[nComp], valueLength[nComp]);
+			pValue += valueLength[nComp];
+		}
+		pEntry->pChain = *ppBucket;
+		*ppBucket = pEntry;
+		pushNewest( shard, pEntry);
+		shard.bytesUsed += entryBytes;
+		++ shard.entries;
+		++ shard.insertions;
+
+	}
+
+	void deliveryLineCache::getStatistics( S_CACHE_STATISTICS &statistics) const {
+		memset( &statistics, 0x0, sizeof( statistics));
+		statistics.bytesLimit = maxBytes;
+		for( size_t nShard = 0; nShards > nShard; ++ nShard) {
+			S_CACHE_SHARD &shard = allShards[nShard];
+			std::lock_guard< std::mutex> lock( shard.shardLock);
+			statistics.hits += shard.hits;
+			statistics.misses += shard.misses;
+			statistics.insertions += shard.insertions;
+			statistics.evictions += shard.evictions;
+			statistics.entries += shard.entries;
+			statistics.bytesUsed += shard.bytesUsed;
+		}
+	}
+
+	void deliveryLineCache::clear() {
+		for( size_t nShard = 0; nShards > nShard; ++ nShard) {
+			S_CACHE_SHARD &shard = allShards[nShard];
+			std::lock_guard< std::mutex> lock( shard.shardLock);
+			while( (S_CACHE_ENTRY *) 0x0 != shard.pOldest) {
+				S_CACHE_ENTRY *pEntry = shard.pOldest;
+				unlinkEntry( shard, pEntry);
+				shard.bytesUsed -= pEntry->nBytes;
+				free( pEntry);
+			}
+			if( 0 != shard.nBuckets) memset( shard.allBuckets, 0x0, shard.nBuckets * sizeof( S_CACHE_ENTRY *));
+			shard.entries = 0;
+		}
+	}
+
+};
@@ -0,0 +1,184 @@
+//
+//  libAddrColumns.cpp
+//  libAddr
+//
+//  Parse results for many lines, stored column by column.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+// Standard includes
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// STL includes
+#include <vector>
+
+// Project includes
+#include <libAddr.hpp>
+#include <libAddrColumns.hpp>
+#include <libAddrHash.hpp>
+
+namespace libAddr {
+
+	// Largest column - Arrow offsets are signed 32 bit
+	#define	COLUMN_MAX_DATA					((size_t) INT32_MAX)
+
+	// Marks an unused dictionary hash slot
+	#define	COLUMN_EMPTY_SLOT				(-1)
+
+	/////// Class deliveryLineColumns functions ///////
+
+	// Construction - empty
+	deliveryLineColumns::deliveryLineColumns() {
+		nRows = 0;
+		clear();
+	}
+
+	// Destruction
+	deliveryLineColumns::~deliveryLineColumns() {
+
+	}
+
+	// Drop every row
+	void deliveryLineColumns::clear() {
+		for( int nComp = 0; LC_COUNT > nComp; ++ nComp) {
+			allOffsets[nComp].assign( 1, 0);
+			allData[nComp].clear();
+			allIndices[nComp].clear();
+			allSlots[nComp].clear();
+
+			// Encoded components start with the empty string as entry zero
+			if( ! isDictionaryEncoded( (E_LINE_COMPONENT) nComp)) continue;
+			allOffsets[nComp].push_back( 0);
+			allSlots[nComp].assign( 64, COLUMN_EMPTY_SLOT);
+			allSlots[nComp][hashDictionaryKey( "", 0) & 63] = 0;
+		}
+		nRows = 0;
+	}
+
+	// Make room for more rows
+	void deliveryLineColumns::reserve( const size_t nMoreRows) {
+		for( int nComp = 0; LC_COUNT > nComp; ++ nComp) {
+			if( isDictionaryEncoded( (E_LINE_COMPONENT) nComp)) allIndices[nComp].reserve( nRows + nMoreRows);
+			else allOffsets[nComp].reserve( nRows + nMoreRows + 1);
+		}
+	}
+
+	// Find or add a value in an encoded component's dictionary
+	int32_t deliveryLineColumns::encode( const int component, const char *pValue, const size_t valueLen) {
+
+		// Already known?
+		std::vector< int32_t> &slots = allSlots[component];
+		std::vector< int32_t> &offsets = allOffsets[component];
+		std::vector< char> &data = allData[component];
+		size_t slotMask = slots.size() - 1;
+		size_t nSlot = (size_t) hashDictionaryKey( pValue, valueLen) & slotMask;
+		for( ; COLUMN_EMPTY_SLOT != slots[nSlot]; nSlot = (nSlot + 1) & slotMask) {
+			const int32_t nEntry = slots[nSlot];
+			if( ((size_t) (offsets[nEntry + 1] - offsets[nEntry]) == valueLen) && (0x0 == memcmp( data.data() + offsets[nEntry], pValue, valueLen))) return( nEntry);
+		}
+
+		// Add it - append has checked there is room
+		const int32_t nEntry = (int32_t) (offsets.size() - 1);
+		data.insert( data.end(), pValue, pValue + valueLen);
+		offsets.push_back( (int32_t) data.size());
+		slots[nSlot] = nEntry;
+
+		// Keep the hash at most half full
+		if( slots.size() < (2 * (size_t) (nEntry + 1))) {
+			slots.assign( 2 * slots.size(), COLUMN_EMPTY_SLOT);
+			slotMask = slots.size() - 1;
+			for( int32_t nRehash = 0; nEntry >= nRehash; ++ nRehash) {
+				nSlot = (size_t) hashDictionaryKey( data.data() + offsets[nRehash], offsets[nRehash + 1] - offsets[nRehash]) & slotMask;
+				while( COLUMN_EMPTY_SLOT != slots[nSlot]) nSlot = (nSlot + 1) & slotMask;
+				slots[nSlot] = nRehash;
+			}
+		}
+		return( nEntry);
+
+	}
+
+	// Add a parsed line as the next row
+	bool deliveryLineColumns::append( const deliveryLine &line) {
+
+		const char *allValues [LC_COUNT] = {
+			line.getStreetNumber(), line.getPreDirectional(), line.getStreetName(), line.getStreetType(), line.getPostDirectional(),
+			line.getUnitType(), line.getUnitNumber(), line.getPOBox(), line.getRuralRoute(), line.getRemainder()
+		};
+
+		// Check every column has room first, so a row is added whole or not at all
+		size_t allLengths [LC_COUNT];
+		for( int nComp = 0; LC_COUNT > nComp; ++ nComp) {
+			allLengths[nComp] = strlen( allValues[nComp]);
+			if( COLUMN_MAX_DATA < (allData[nComp].size() + allLengths[nComp])) return( false);
+		}
+
+		// Then add it
+		for( int nComp = 0; LC_COUNT > nComp; ++ nComp) {
+			if( isDictionaryEncoded( (E_LINE_COMPONENT) nComp)) {
+				allIndices[nComp].push_back( (0 == allLengths[nComp]) ? 0 : encode( nComp, allValues[nComp], allLengths[nComp]));
+				continue;
+			}
+			allData[nComp].insert( allData[nComp].end(), allValues[nComp], allValues[nComp] + allLengths[nComp]);
+			allOffsets[nComp].push_back( (int32_t) allData[nComp].size());
+		}
+		++ nRows;
+		return( true);
+
+	}
+
+	// The strings of a component
+	S_STRING_COLUMN deliveryLineColumns::getStrings( const E_LINE_COMPONENT component) const {
+		S_STRING_COLUMN column;
+		column.offsets = allOffsets[component].data();
+		column.data = allData[component].data();
+		column.nValues = allOffsets[component].size() - 1;
+		return( column);
+	}
+
+	// The dictionary index of each row
+	const int32_t * deliveryLineColumns::getIndices( const E_LINE_COMPONENT component) const {
+		return( isDictionaryEncoded( component) ? allIndices[component].data() : (const int32_t *) 0x0);
+	}
+
+	// Return one value and its length
+	size_t deliveryLineColumns::getValue( const size_t nRow, const E_LINE_COMPONENT component, const char *&pValue) const {
+		pValue = "";
+		if( nRows <= nRow) return( 0);
+		const size_t nValue = isDictionaryEncoded( component) ? (size_t) allIndices[component][nRow] : nRow;
+		const std::vector< int32_t> &offsets = allOffsets[component];
+		const size_t valueLen = (size_t) (offsets[nValue + 1] - offsets[nValue]);
+		if( 0 != valueLen) pValue = allData[component].data() + offsets[nValue];
+		return( valueLen);
+	}
+
+};
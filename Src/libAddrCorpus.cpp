@@ -0,0 +1,301 @@
+//
+//  libAddrCorpus.cpp
+//  libAddr
+//
+//  A deterministic generator of synthetic delivery lines.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// Project includes
+#include <libAddr.hpp>
+#include <libAddrCorpus.hpp>
+
+namespace libAddr {
+
+	// Most words in one generated line
+	#define	MAX_CORPUS_WORDS					(24)
+
+	// Words for street names and remainders - none is a unit type or a directional
+	static const char * const CORPUS_NAME_WORDS [] = {
+		"CEDAR", "MAIN", "CITRUS", "GROVE", "BROKEN", "SOUND", "OAK", "MAPLE", "WASHINGTON", "LINCOLN",
+		"SUNSET", "MARTIN", "LUTHER", "KING", "ELM", "OLD", "MILL", "LAKE", "SHORE", "PINE",
+		"RIDGE", "JEFFERSON", "MADISON", "CHURCH", "WILLOW", "HICKORY", "SPRING", "VALLEY", "FOREST", "HIGHLAND",
+		"RIVER", "MEADOW", "CHESTNUT", "BIRCH", "LAUREL", "MAGNOLIA", "2ND", "3RD", "10TH", "42ND",
+		0x0
+	};
+
+	// Numbered highway words
+	static const char * const CORPUS_HIGHWAY_PREFIXES [] = { "STATE", "US", "COUNTY", "FM", 0x0 };
+	static const char * const CORPUS_HIGHWAY_TYPES [] = { "HWY", "HIGHWAY", "HIWAY", "HWAY", 0x0 };
+
+	// Stray punctuation added as noise
+	static const char * const CORPUS_NOISE [] = { ".", ",", " ", " -", 0x0 };
+
+	// The words of a line being built
+	struct s_corpus_words {
+		const char *allWords [MAX_CORPUS_WORDS];
+		char acNumbers [MAX_CORPUS_WORDS][16];
+		int nWords;
+	};
+	typedef struct s_corpus_words S_CORPUS_WORDS;
+
+	// Count a zero terminated list
+	static size_t countWords( const char * const *allWords) {
+		size_t nWords = 0;
+		while( (const char *) 0x0 != allWords[nWords]) ++ nWords;
+		return( nWords);
+	}
+
+	// Count a zero terminated conversion table
+	static size_t countConversions( const S_CONVERSION_TYPE *table) {
+		size_t nEntries = 0;
+		while( (const char *) 0x0 != table[nEntries].type) ++ nEntries;
+		return( nEntries);
+	}
+
+	// Insert a word at a position
+	static void insertWord( S_CORPUS_WORDS &words, const int nAt, const char *pWord) {
+		if( MAX_CORPUS_WORDS <= words.nWords) return;
+		for( int nWord = words.nWords; nAt < nWord; -- nWord) words.allWords[nWord] = words.allWords[nWord - 1];
+		words.allWords[nAt] = pWord;
+		++ words.nWords;
+	}
+
+	// Add a word at the end
+	static void addWord( S_CORPUS_WORDS &words, const char *pWord) {
+		insertWord( words, words.nWords, pWord);
+	}
+
+	// Add a number at the end, with an optional leading text
+	static void addNumber( S_CORPUS_WORDS &words, const char *pLead, const uint32_t nNumber) {
+		if( MAX_CORPUS_WORDS <= words.nWords) return;
+		char *pText = words.acNumbers[words.nWords];
+		snprintf( pText, sizeof( words.acNumbers[0]), "%s%u", pLead, nNumber);
+		addWord( words, pText);
+	}
+
+	// Length of the words joined by blanks
+	static size_t joinedLength( const S_CORPUS_WORDS &words) {
+		size_t nLength = 0;
+		for( int nWord = 0; words.nWords > nWord; ++ nWord) nLength += strlen( words.allWords[nWord]) + ((0 == nWord) ? 0 : 1);
+		return( nLength);
+	}
+
+	/////////////////////////////////////
+	// Class corpusGenerator functions //
+	/////////////////////////////////////
+
+	void corpusGenerator::defaultOptions( S_CORPUS_OPTIONS &options) {
+		const uint32_t DEFAULT_PATH_WEIGHTS [CP_COUNT] = { 40, 15, 5, 10, 15, 10, 5 };
+		const uint32_t DEFAULT_CASING_WEIGHTS [CC_COUNT] = { 40, 10, 40, 10 };
+		options.seed = 1;
+		memcpy( options.pathWeight, DEFAULT_PATH_WEIGHTS, sizeof( options.pathWeight));
+		memcpy( options.casingWeight, DEFAULT_CASING_WEIGHTS, sizeof( options.casingWeight));
+		options.minLength = 16;
+		options.maxLength = 40;
+		options.punctuationPercent = 5;
+	}
+
+	corpusGenerator::corpusGenerator( const S_CORPUS_OPTIONS &runOptions) : options( runOptions), lastPath( CP_STREET) {
+
+		// Keep lengths sane
+		if( MAX_CORPUS_LINE_SIZE / 2 < options.maxLength) options.maxLength = MAX_CORPUS_LINE_SIZE / 2;
+		if( options.maxLength < options.minLength) options.minLength = options.maxLength;
+
+		// Spread the seed over the state (splitmix64) - the state must not be zero
+		uint64_t mixed = options.seed + 0x9E3779B97F4A7C15ULL;
+		mixed = (mixed ^ (mixed >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		mixed = (mixed ^ (mixed >> 27)) * 0x94D049BB133111EBULL;
+		state = mixed ^ (mixed >> 31);
+		if( 0 == state) state = 0x9E3779B97F4A7C15ULL;
+
+	}
+
+	corpusGenerator::~corpusGenerator() {
+	}
+
+	uint64_t corpusGenerator::nextRandom() {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return( state * 0x2545F4914F6CDD1DULL);
+	}
+
+	uint32_t corpusGenerator::nextBelow( const uint32_t nLimit) {
+		return( (uint32_t) (((nextRandom() >> 32) * (uint64_t) nLimit) >> 32));
+	}
+
+	int corpusGenerator::pickWeighted( const uint32_t *weights, const int nWeights) {
+		uint64_t nTotal = 0;
+		for( int nPos = 0; nWeights > nPos; ++ nPos) nTotal += weights[nPos];
+		if( 0 == nTotal) return( 0);
+		uint64_t nPick = (nextRandom() >> 11) % nTotal;
+		for( int nPos = 0; nWeights > nPos; ++ nPos) {
+			if( weights[nPos] > nPick) return( nPos);
+			nPick -= weights[nPos];
+		}
+		return( nWeights - 1);
+	}
+
+	size_t corpusGenerator::nextLine( char *lineBuffer, const size_t lineBufferSize) {
+
+		// Local variables
+		addressCompression addrComp;
+		S_CORPUS_WORDS words;
+		words.nWords = 0;
+		int nPadAt = 0;
+		size_t nNameLength = 0;
+
+		// Pick the shape
+		lastPath = (E_CORPUS_PATH) pickWeighted( options.pathWeight, CP_COUNT);
+		const E_CORPUS_CASING eCasing = (E_CORPUS_CASING) pickWeighted( options.casingWeight, CC_COUNT);
+		const uint32_t nTargetLength = options.minLength + nextBelow( options.maxLength - options.minLength + 1);
+
+		// Common picks
+		const size_t nNames = countWords( CORPUS_NAME_WORDS);
+		const S_CONVERSION_TYPE &ctStreet = addressCompression::KNOWN_STREET_TYPES[nextBelow( (uint32_t) countConversions( addressCompression::KNOWN_STREET_TYPES))];
+		const char *pStreetType = (0 == nextBelow( 4)) ? ctStreet.preftype : ctStreet.type;
+		const char *pUnitType;
+		do {
+			const S_CONVERSION_TYPE &ctUnit = addressCompression::KNOWN_UNIT_TYPES[nextBelow( (uint32_t) countConversions( addressCompression::KNOWN_UNIT_TYPES))];
+			pUnitType = (0 == nextBelow( 4)) ? ctUnit.preftype : ctUnit.type;
+		} while( (const S_CONVERSION_TYPE *) 0x0 != addrComp.lookupStreetType( pUnitType));
+		const char *pDirectional = addressCompression::KNOWN_DIRECTIONALS[nextBelow( (uint32_t) countWords( addressCompression::KNOWN_DIRECTIONALS))];
+		const char *pName = CORPUS_NAME_WORDS[nextBelow( (uint32_t) nNames)];
+		const uint32_t nNumber = 1 + nextBelow( 29999);
+		const uint32_t nSecond = 1 + nextBelow( 999);
+
+		// Build the words for the path
+		// nPadAt is where padding words go: inside the street name, or at the end as a remainder
+		// nNameLength is the length of the street name, which must stay inside one element
+		switch( lastPath) {
+			case CP_STREET:
+				addNumber( words, "", nNumber);
+				if( 0 == nextBelow( 3)) addWord( words, pDirectional);
+				addWord( words, pName);
+				nNameLength = strlen( pName);
+				nPadAt = words.nWords;
+				addWord( words, pStreetType);
+				if( 0 == nextBelow( 6)) addWord( words, addressCompression::KNOWN_DIRECTIONALS[nextBelow( (uint32_t) countWords( addressCompression::KNOWN_DIRECTIONALS))]);
+				break;
+			case CP_UNIT_AFTER:
+				addNumber( words, "", nNumber);
+				addWord( words, pName);
+				nNameLength = strlen( pName);
+				nPadAt = words.nWords;
+				addWord( words, pStreetType);
+				addWord( words, pUnitType);
+				addNumber( words, "", nSecond);
+				break;
+			case CP_UNIT_BEFORE:
+				addNumber( words, "", nNumber);
+				addWord( words, pUnitType);
+				addNumber( words, "", nSecond);
+				addWord( words, pName);
+				nNameLength = strlen( pName);
+				nPadAt = words.nWords;
+				addWord( words, pStreetType);
+				break;
+			case CP_HASH_UNIT:
+				addNumber( words, "", nNumber);
+				addWord( words, pName);
+				nNameLength = strlen( pName);
+				nPadAt = words.nWords;
+				addWord( words, pStreetType);
+				if( 0 == nextBelow( 2)) addNumber( words, "#", nSecond);
+				else {
+					addWord( words, "#");
+					addNumber( words, "", nSecond);
+				}
+				break;
+			case CP_PO_BOX:
+				addWord( words, addressCompression::KNOWN_PO_BOX_HEADERS[nextBelow( (uint32_t) countWords( addressCompression::KNOWN_PO_BOX_HEADERS))]);
+				addNumber( words, "", nNumber);
+				nPadAt = words.nWords;
+				break;
+			case CP_RURAL_ROUTE:
+				addWord( words, addressCompression::KNOWN_RURAL_ROUTE_HEADERS[nextBelow( (uint32_t) countWords( addressCompression::KNOWN_RURAL_ROUTE_HEADERS))]);
+				addNumber( words, "", 1 + nSecond % 40);
+				addWord( words, "BOX");
+				addNumber( words, "", nNumber);
+				nPadAt = words.nWords;
+				break;
+			default:
+				addNumber( words, "", nNumber);
+				addWord( words, CORPUS_HIGHWAY_PREFIXES[nextBelow( (uint32_t) countWords( CORPUS_HIGHWAY_PREFIXES))]);
+				nPadAt = words.nWords;
+				addWord( words, CORPUS_HIGHWAY_TYPES[nextBelow( (uint32_t) countWords( CORPUS_HIGHWAY_TYPES))]);
+				addNumber( words, "", nSecond);
+				nNameLength = joinedLength( words) - strlen( words.allWords[0]) - 1;
+				break;
+		}
+
+		// Pad toward the target length
+		size_t nLength = joinedLength( words);
+		while( MAX_CORPUS_WORDS > words.nWords) {
+			const char *pPad = CORPUS_NAME_WORDS[nextBelow( (uint32_t) nNames)];
+			if( nTargetLength < nLength + 1 + strlen( pPad)) break;
+			if( (0 < nNameLength) && (MAX_DELIVERY_LINE_ELEMENT_SIZE <= nNameLength + 1 + strlen( pPad))) break;
+			insertWord( words, nPadAt ++, pPad);
+			nLength += 1 + strlen( pPad);
+			if( 0 < nNameLength) nNameLength += 1 + strlen( pPad);
+		}
+
+		// Write the words out with casing and noise
+		// The headers end in a blank which is dropped here
+		size_t nOut = 0;
+		for( int nWord = 0; words.nWords > nWord; ++ nWord) {
+
+			const char *pWord = words.allWords[nWord];
+			size_t wordLen = strlen( pWord);
+			while( (0 < wordLen) && (' ' == pWord[wordLen - 1])) -- wordLen;
+			const char *pNoise = (nextBelow( 100) < options.punctuationPercent) ? CORPUS_NOISE[nextBelow( (uint32_t) countWords( CORPUS_NOISE))] : "";
+			if( lineBufferSize <= nOut + 1 + wordLen + strlen( pNoise)) break;
+
+			E_CORPUS_CASING eWordCasing = (CC_MIXED == eCasing) ? (E_CORPUS_CASING) nextBelow( CC_MIXED) : eCasing;
+			if( 0 != nWord) lineBuffer[nOut ++] = ' ';
+			for( size_t nPos = 0; wordLen > nPos; ++ nPos) {
+				const bool bUpper = (CC_UPPER == eWordCasing) || ((CC_TITLE == eWordCasing) && ((0 == nPos) || (' ' == pWord[nPos - 1])));
+				lineBuffer[nOut ++] = bUpper ? (char) toupper( (unsigned char) pWord[nPos]) : (char) tolower( (unsigned char) pWord[nPos]);
+			}
+			for( size_t nPos = 0; 0x0 != pNoise[nPos]; ++ nPos) lineBuffer[nOut ++] = pNoise[nPos];
+
+		}
+		lineBuffer[nOut] = 0x0;
+		return( nOut);
+
+	}
+
+};
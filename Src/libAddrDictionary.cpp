@@ -0,0 +1,593 @@
+//
+//  libAddrDictionary.cpp
+//  libAddr
+//
+//  Compiled dictionary files, mapped into memory and used in place.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+// Standard includes
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// STL includes
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Project includes
+#include <libAddr.hpp>
+#include <libAddrDictionary.hpp>
+#include <libAddrHash.hpp>
+
+namespace libAddr {
+
+	// The automaton classes must match the parser's
+	static_assert( DICTIONARY_HEADER_CLASSES == HEADER_CLASS_COUNT, "Header classes differ from the parser");
+
+	// Section names of a source, in table order
+	static const char * const DICTIONARY_SECTIONS [] = { "street_types", "unit_types", "other_conversions", "directionals", "po_box_headers", "rural_route_headers", 0x0 };
+
+	// Longest key or value in a source
+	#define	DICTIONARY_MAX_KEY				(64)
+
+	// Longest line in a source
+	#define	DICTIONARY_MAX_LINE				(1024)
+
+	// Headers per list - the automaton keeps the index in eight bits
+	#define	DICTIONARY_MAX_HEADERS			(255)
+
+	// Sections are aligned to this
+	#define	DICTIONARY_ALIGNMENT			(8)
+
+	// Is a table a header list?
+	static inline bool isHeaderTable( const int table) {
+		return( (DT_PO_BOX_HEADERS == table) || (DT_RURAL_ROUTE_HEADERS == table));
+	}
+
+	// Round up to the section alignment
+	static inline size_t alignSection( const size_t offset) {
+		return( (offset + DICTIONARY_ALIGNMENT - 1) & ~((size_t) DICTIONARY_ALIGNMENT - 1));
+	}
+
+	// Is a range within a file?
+	static inline bool isWithin( const uint64_t offset, const uint64_t count, const uint64_t size, const uint64_t fileSize) {
+		return( (offset <= fileSize) && ((count * size) <= (fileSize - offset)));
+	}
+
+	// Trim blanks from both ends of a string in place
+	static char * trimBlanks( char *pText) {
+		while( isspace( (unsigned char) *pText)) ++ pText;
+		size_t textLen = strlen( pText);
+		while( (0 < textLen) && isspace( (unsigned char) pText[textLen - 1])) pText[-- textLen] = 0x0;
+		return( pText);
+	}
+
+	/////// Class addressDictionary functions ///////
+
+	// Construction - nothing open
+	addressDictionary::addressDictionary() {
+		pBase = (const uint8_t *) 0x0;
+		mapSize = 0;
+		pHeader = (const S_DICTIONARY_HEADER *) 0x0;
+		allStates = (const S_DICTIONARY_STATE *) 0x0;
+		for( int nTable = 0; DT_COUNT > nTable; ++ nTable) {
+			allSlots[nTable] = (const uint32_t *) 0x0;
+			allEntries[nTable] = (S_CONVERSION_TYPE *) 0x0;
+			nEntries[nTable] = 0;
+		}
+		acError[0] = 0x0;
+	}
+
+	// Destruction - closes the file
+	addressDictionary::~addressDictionary() {
+		close();
+	}
+
+	// Fail with a reason
+	bool addressDictionary::fail( const char *pFormat, ...) {
+		va_list args;
+		va_start( args, pFormat);
+		vsnprintf( acError, sizeof( acError), pFormat, args);
+		va_end( args);
+		return( false);
+	}
+
+	// Map a compiled dictionary file
+	bool addressDictionary::open( const char *pFileName) {
+
+		// Start over
+		close();
+		acError[0] = 0x0;
+		if( (const char *) 0x0 == pFileName) return( fail( "No file name"));
+
+		// Map the file
+		const int fd = ::open( pFileName, O_RDONLY);
+		if( 0 > fd) return( fail( "Unable to open %s: %s", pFileName, strerror( errno)));
+		struct stat fileStat;
+		if( 0 != fstat( fd, &fileStat)) {
+			::close( fd);
+			return( fail( "Unable to read %s: %s", pFileName, strerror( errno)));
+		}
+		if( sizeof( S_DICTIONARY_HEADER) > (size_t) fileStat.st_size) {
+			::close( fd);
+			return( fail( "%s is too small to be a dictionary", pFileName));
+		}
+		void *pMap = mmap( (void *) 0x0, (size_t) fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close( fd);
+		if( MAP_FAILED == pMap) return( fail( "Unable to map %s: %s", pFileName, strerror( errno)));
+		pBase = (const uint8_t *) pMap;
+		mapSize = (size_t) fileStat.st_size;
+		pHeader = (const S_DICTIONARY_HEADER *) pBase;
+
+		// Identify it
+		if( (0x0 != memcmp( pHeader->magic, DICTIONARY_MAGIC, sizeof( pHeader->magic))) || (DICTIONARY_VERSION != pHeader->version) || (mapSize != pHeader->fileSize)) {
+			close();
+			return( fail( "%s is not a version %d dictionary", pFileName, DICTIONARY_VERSION));
+		}
+
+		// The string pool must be in the file and end in a terminator
+		const uint64_t fileSize = mapSize;
+		if( (0 == pHeader->stringSize) || ! isWithin( pHeader->stringOffset, pHeader->stringSize, 1, fileSize) || (0x0 != pBase[pHeader->stringOffset + pHeader->stringSize - 1])) {
+			close();
+			return( fail( "%s has a damaged string pool", pFileName));
+		}
+		const char *pStrings = (const char *) pBase + pHeader->stringOffset;
+
+		// Check the tables and point the entries into the string pool
+		for( int nTable = 0; DT_COUNT > nTable; ++ nTable) {
+			const S_DICTIONARY_TABLE &table = pHeader->tables[nTable];
+			bool bValid = (0 == (table.entryOffset % sizeof( uint32_t))) && (0 == (table.slotOffset % sizeof( uint32_t)))
+				&& isWithin( table.entryOffset, table.nEntries, sizeof( S_DICTIONARY_ENTRY), fileSize)
+				&& isWithin( table.slotOffset, table.nSlots, sizeof( uint32_t), fileSize)
+				&& (table.nEntries < table.nSlots) && (0 == (table.nSlots & (table.nSlots - 1)))
+				&& (! isHeaderTable( nTable) || (DICTIONARY_MAX_HEADERS >= table.nEntries));
+			if( ! bValid) {
+				close();
+				return( fail( "%s has a damaged %s table", pFileName, DICTIONARY_SECTIONS[nTable]));
+			}
+			const S_DICTIONARY_ENTRY *pEntries = (const S_DICTIONARY_ENTRY *) (pBase + table.entryOffset);
+			allSlots[nTable] = (const uint32_t *) (pBase + table.slotOffset);
+			allEntries[nTable] = new S_CONVERSION_TYPE [table.nEntries + 1];
+			nEntries[nTable] = table.nEntries;
+			for( uint32_t nEntry = 0; table.nEntries > nEntry; ++ nEntry) {
+				bValid &= (pEntries[nEntry].typeOffset < pHeader->stringSize) && (pEntries[nEntry].preftypeOffset < pHeader->stringSize);
+				if( ! bValid) break;
+				allEntries[nTable][nEntry].type = pStrings + pEntries[nEntry].typeOffset;
+				allEntries[nTable][nEntry].preftype = pStrings + pEntries[nEntry].preftypeOffset;
+			}
+			allEntries[nTable][table.nEntries].type = (const char *) 0x0;
+			allEntries[nTable][table.nEntries].preftype = (const char *) 0x0;
+			for( uint32_t nSlot = 0; bValid && (table.nSlots > nSlot); ++ nSlot) {
+				bValid = (DICTIONARY_EMPTY_SLOT == allSlots[nTable][nSlot]) || (table.nEntries > allSlots[nTable][nSlot]);
+			}
+			if( ! bValid) {
+				close();
+				return( fail( "%s has a damaged %s table", pFileName, DICTIONARY_SECTIONS[nTable]));
+			}
+		}
+
+		// Check the automaton - every step goes one character deeper, so a match always ends
+		bool bValid = (0 != pHeader->nStates) && (0 == (pHeader->stateOffset % sizeof( uint16_t)))
+			&& isWithin( pHeader->stateOffset, pHeader->nStates, sizeof( S_DICTIONARY_STATE), fileSize);
+		if( bValid) {
+			allStates = (const S_DICTIONARY_STATE *) (pBase + pHeader->stateOffset);
+			bValid = (0 == allStates[0].depth) && (0 == allStates[0].accept);
+		}
+		for( uint32_t nState = 0; bValid && (pHeader->nStates > nState); ++ nState) {
+			const S_DICTIONARY_STATE &state = allStates[nState];
+			bValid = (0 == state.next[0]);
+			for( int nClass = 1; bValid && (DICTIONARY_HEADER_CLASSES > nClass); ++ nClass) {
+				const uint16_t nNext = state.next[nClass];
+				bValid = (0 == nNext) || ((pHeader->nStates > nNext) && ((state.depth + 1) == allStates[nNext].depth));
+			}
+			if( bValid && (0 != state.accept)) {
+				const uint16_t nList = state.accept >> 8;
+				const uint16_t nHeader = state.accept & 0xFF;
+				bValid = (1 >= nList) && (0 != nHeader) && (nEntries[DT_PO_BOX_HEADERS + nList] >= nHeader);
+			}
+		}
+		if( ! bValid) {
+			close();
+			return( fail( "%s has a damaged header automaton", pFileName));
+		}
+
+		return( true);
+
+	}
+
+	// Unmap the file
+	void addressDictionary::close() {
+		for( int nTable = 0; DT_COUNT > nTable; ++ nTable) {
+			delete [] allEntries[nTable];
+			allEntries[nTable] = (S_CONVERSION_TYPE *) 0x0;
+			allSlots[nTable] = (const uint32_t *) 0x0;
+			nEntries[nTable] = 0;
+		}
+		if( (const uint8_t *) 0x0 != pBase) munmap( (void *) pBase, mapSize);
+		pBase = (const uint8_t *) 0x0;
+		mapSize = 0;
+		pHeader = (const S_DICTIONARY_HEADER *) 0x0;
+		allStates = (const S_DICTIONARY_STATE *) 0x0;
+	}
+
+	// Find a key of known length
+	const S_CONVERSION_TYPE * addressDictionary::lookup( const E_DICTIONARY_TABLE table, const char *key, const size_t keyLen) const {
+
+		// Nothing to find?
+		if( (const uint8_t *) 0x0 == pBase) return( (const S_CONVERSION_TYPE *) 0x0);
+
+		// Probe from the home slot - there is always an empty slot to stop at
+		const uint32_t *pSlots = allSlots[table];
+		const size_t slotMask = pHeader->tables[table].nSlots - 1;
+		size_t nSlot = (size_t) hashDictionaryKey( key, keyLen) & slotMask;
+		for( size_t nProbe = 0; slotMask >= nProbe; ++ nProbe) {
+			const uint32_t nEntry = pSlots[nSlot];
+			if( DICTIONARY_EMPTY_SLOT == nEntry) break;
+			const char *pType = allEntries[table][nEntry].type;
+			if( (0x0 == strncmp( pType, key, keyLen)) && (0x0 == pType[keyLen])) return( allEntries[table] + nEntry);
+			nSlot = (nSlot + 1) & slotMask;
+		}
+		return( (const S_CONVERSION_TYPE *) 0x0);
+
+	}
+
+	// Match the longest PO box or rural route header at the start of a cleaned line
+	E_LINE_COMPONENT addressDictionary::matchLineHeader( const char *text, size_t &headerLen, size_t &nHeader) const {
+
+		// Nothing to match?
+		headerLen = 0;
+		if( (const uint8_t *) 0x0 == pBase) return( LC_COUNT);
+
+		// Walk the automaton, remembering the last header passed
+		uint16_t bestAccept = 0;
+		size_t nState = 0;
+		for( const char *pText = text; ; ++ pText) {
+			nState = allStates[nState].next[headerCharClass( *pText)];
+			if( 0 == nState) break;
+			if( 0 != allStates[nState].accept) {
+				bestAccept = allStates[nState].accept;
+				headerLen = allStates[nState].depth;
+			}
+		}
+		if( 0 == bestAccept) return( LC_COUNT);
+		nHeader = (bestAccept & 0xFF) - 1;
+		return( (0 == (bestAccept >> 8)) ? LC_PO_BOX : LC_RURAL_ROUTE);
+
+	}
+
+	// Compile a text source into a dictionary file
+	bool addressDictionary::compile( FILE *fSource, const char *pOutputFile) {
+
+		// The entries read, per table
+		std::vector< std::string> allKeys [DT_COUNT];
+		std::vector< std::string> allValues [DT_COUNT];
+
+		// Read the source
+		acError[0] = 0x0;
+		if( ((FILE *) 0x0 == fSource) || ((const char *) 0x0 == pOutputFile)) return( fail( "No source or output"));
+		char acLine [DICTIONARY_MAX_LINE + 2];
+		int nTable = -1;
+		for( int nLine = 1; (char *) 0x0 != fgets( acLine, sizeof( acLine), fSource); ++ nLine) {
+
+			// Drop comments and blanks
+			if( (0x0 == strchr( acLine, '\n')) && ! feof( fSource)) return( fail( "Line %d is too long", nLine));
+			char *pComment = strchr( acLine, '#');
+			if( (char *) 0x0 != pComment) *pComment = 0x0;
+			char *pText = trimBlanks( acLine);
+			if( 0x0 == *pText) continue;
+
+			// A section?
+			if( '[' == *pText) {
+				char *pClose = strchr( pText, ']');
+				if( ((char *) 0x0 == pClose) || (0x0 != pClose[1])) return( fail( "Line %d: malformed section", nLine));
+				*pClose = 0x0;
+				for( nTable = 0; (const char *) 0x0 != DICTIONARY_SECTIONS[nTable]; ++ nTable) {
+					if( 0x0 == strcmp( pText + 1, DICTIONARY_SECTIONS[nTable])) break;
+				}
+				if( DT_COUNT == nTable) return( fail( "Line %d: unknown section %s", nLine, pText + 1));
+				continue;
+			}
+			if( 0 > nTable) return( fail( "Line %d: entry before any section", nLine));
+
+			// Split the key and value - the value defaults to the key
+			char *pValue = strchr( pText, ',');
+			if( (char *) 0x0 != pValue) *pValue ++ = 0x0;
+			char *pKey = trimBlanks( pText);
+			pValue = ((char *) 0x0 == pValue) ? pKey : trimBlanks( pValue);
+			for( char *pChar = pKey; 0x0 != *pChar; ++ pChar) *pChar = (char) toupper( (unsigned char) *pChar);
+			for( char *pChar = pValue; 0x0 != *pChar; ++ pChar) *pChar = (char) toupper( (unsigned char) *pChar);
+
+			// Check the key
+			const size_t keyLen = strlen( pKey);
+			if( (0 == keyLen) || (0x0 == *pValue)) return( fail( "Line %d: missing key or value", nLine));
+			if( (DICTIONARY_MAX_KEY < keyLen) || (DICTIONARY_MAX_KEY < strlen( pValue))) return( fail( "Line %d: key or value is too long", nLine));
+			for( const char *pChar = pKey; 0x0 != *pChar; ++ pChar) {
+				if( isHeaderTable( nTable) ? (0 == headerCharClass( *pChar)) : (' ' == *pChar)) return( fail( "Line %d: %s may not hold '%c'", nLine, pKey, *pChar));
+			}
+			if( ((DT_STREET_TYPES == nTable) || (DT_UNIT_TYPES == nTable)) && isdigit( (unsigned char) *pKey)) return( fail( "Line %d: %s starts with a digit", nLine, pKey));
+
+			// Headers are matched with the blank that follows them
+			std::string key( pKey);
+			if( isHeaderTable( nTable)) {
+				if( DICTIONARY_MAX_HEADERS <= allKeys[nTable].size()) return( fail( "Line %d: too many headers", nLine));
+				key += ' ';
+			}
+
+			// No repeats - a header may not be in both lists
+			for( int nCheck = 0; DT_COUNT > nCheck; ++ nCheck) {
+				if( (nCheck != nTable) && ! (isHeaderTable( nCheck) && isHeaderTable( nTable))) continue;
+				for( const std::string &existing : allKeys[nCheck]) {
+					if( existing == key) return( fail( "Line %d: %s is repeated", nLine, pKey));
+				}
+			}
+			allKeys[nTable].push_back( key);
+			allValues[nTable].push_back( std::string( pValue));
+
+		}
+		if( ferror( fSource)) return( fail( "Unable to read the source"));
+
+		// Lay out the file - header, automaton, strings, then each table's entries and slots
+		size_t nStates = 1;
+		size_t stringSize = 0;
+		for( int nTable = 0; DT_COUNT > nTable; ++ nTable) {
+			for( size_t nEntry = 0; allKeys[nTable].size() > nEntry; ++ nEntry) {
+				if( isHeaderTable( nTable)) nStates += allKeys[nTable][nEntry].size();
+				stringSize += allKeys[nTable][nEntry].size() + allValues[nTable][nEntry].size() + 2;
+			}
+		}
+		if( 0xFFFF < nStates) return( fail( "The headers are too long"));
+		S_DICTIONARY_HEADER header;
+		memset( &header, 0x0, sizeof( header));
+		memcpy( header.magic, DICTIONARY_MAGIC, sizeof( header.magic));
+		header.version = DICTIONARY_VERSION;
+		size_t fileSize = alignSection( sizeof( S_DICTIONARY_HEADER));
+		header.stateOffset = (uint32_t) fileSize;
+		header.nStates = (uint32_t) nStates;
+		fileSize = alignSection( fileSize + nStates * sizeof( S_DICTIONARY_STATE));
+		header.stringOffset = (uint32_t) fileSize;
+		header.stringSize = (uint32_t) (stringSize + 1);
+		fileSize = alignSection( fileSize + stringSize + 1);
+		for( int nTable = 0; DT_COUNT > nTable; ++ nTable) {
+			size_t nSlots = 1;
+			while( nSlots < (2 * allKeys[nTable].size() + 1)) nSlots <<= 1;
+			header.tables[nTable].nEntries = (uint32_t) allKeys[nTable].size();
+			header.tables[nTable].nSlots = (uint32_t) nSlots;
+			header.tables[nTable].entryOffset = (uint32_t) fileSize;
+			fileSize = alignSection( fileSize + allKeys[nTable].size() * sizeof( S_DICTIONARY_ENTRY));
+			header.tables[nTable].slotOffset = (uint32_t) fileSize;
+			fileSize = alignSection( fileSize + nSlots * sizeof( uint32_t));
+		}
+		if( 0xFFFFFFFF < fileSize) return( fail( "The dictionary is too large"));
+		header.fileSize = (uint32_t) fileSize;
+
+		// Build it
+		std::vector< uint8_t> image( fileSize, 0);
+		memcpy( image.data(), &header, sizeof( header));
+		S_DICTIONARY_STATE *pStates = (S_DICTIONARY_STATE *) (image.data() + header.stateOffset);
+		char *pStrings = (char *) image.data() + header.stringOffset;
+		size_t nUsedStates = 1;
+		size_t nUsedString = 1;
+		for( int nTable = 0; DT_COUNT > nTable; ++ nTable) {
+			const S_DICTIONARY_TABLE &table = header.tables[nTable];
+			S_DICTIONARY_ENTRY *pEntries = (S_DICTIONARY_ENTRY *) (image.data() + table.entryOffset);
+			uint32_t *pSlots = (uint32_t *) (image.data() + table.slotOffset);
+			for( uint32_t nSlot = 0; table.nSlots > nSlot; ++ nSlot) pSlots[nSlot] = DICTIONARY_EMPTY_SLOT;
+			for( uint32_t nEntry = 0; table.nEntries > nEntry; ++ nEntry) {
+
+				// The strings
+				const std::string &key = allKeys[nTable][nEntry];
+				const std::string &value = allValues[nTable][nEntry];
+				pEntries[nEntry].typeOffset = (uint32_t) nUsedString;
+				memcpy( pStrings + nUsedString, key.c_str(), key.size() + 1);
+				nUsedString += key.size() + 1;
+				pEntries[nEntry].preftypeOffset = (uint32_t) nUsedString;
+				memcpy( pStrings + nUsedString, value.c_str(), value.size() + 1);
+				nUsedString += value.size() + 1;
+
+				// The hash slot
+				size_t nSlot = (size_t) hashDictionaryKey( key.c_str(), key.size()) & (table.nSlots - 1);
+				while( DICTIONARY_EMPTY_SLOT != pSlots[nSlot]) nSlot = (nSlot + 1) & (table.nSlots - 1);
+				pSlots[nSlot] = nEntry;
+
+				// The header path
+				if( ! isHeaderTable( nTable)) continue;
+				size_t nState = 0;
+				for( const char cValue : key) {
+					const uint8_t charClass = headerCharClass( cValue);
+					if( 0 == pStates[nState].next[charClass]) {
+						pStates[nUsedStates].depth = (uint16_t) (pStates[nState].depth + 1);
+						pStates[nState].next[charClass] = (uint16_t) nUsedStates ++;
+					}
+					nState = pStates[nState].next[charClass];
+				}
+				pStates[nState].accept = (uint16_t) (((nTable - DT_PO_BOX_HEADERS) << 8) | (nEntry + 1));
+
+			}
+		}
+
+		// Write it aside and rename it into place
+		std::string tempFile( pOutputFile);
+		tempFile += ".tmp";
+		FILE *fOutput = fopen( tempFile.c_str(), "wb");
+		if( (FILE *) 0x0 == fOutput) return( fail( "Unable to create %s: %s", tempFile.c_str(), strerror( errno)));
+		const bool bWritten = (1 == fwrite( image.data(), image.size(), 1, fOutput));
+		if( (0 != fclose( fOutput)) || ! bWritten) {
+			unlink( tempFile.c_str());
+			return( fail( "Unable to write %s", tempFile.c_str()));
+		}
+		if( 0 != rename( tempFile.c_str(), pOutputFile)) {
+			unlink( tempFile.c_str());
+			return( fail( "Unable to rename %s: %s", tempFile.c_str(), strerror( errno)));
+		}
+		return( true);
+
+	}
+
+	/////// Class dictionaryHandle functions ///////
+
+	// Construction
+	dictionaryHandle::dictionaryHandle( addressDictionary *pInitial) : pCurrent( pInitial), epoch( 0) {
+		acError[0] = 0x0;
+	}
+
+	// Destruction - every version is deleted
+	dictionaryHandle::~dictionaryHandle() {
+		for( S_DICTIONARY_RETIRED &retired : allRetired) delete retired.pDictionary;
+		for( S_DICTIONARY_READER *pReader : allReaders) delete pReader;
+		delete pCurrent.load();
+	}
+
+	// Make a version current
+	void dictionaryHandle::publish( addressDictionary *pDictionary) {
+
+		// Swap first, then advance - a reader that sees the new epoch sees the new version
+		std::lock_guard< std::mutex> lock( writerLock);
+		const addressDictionary *pOld = pCurrent.exchange( pDictionary, std::memory_order_seq_cst);
+		const uint64_t retireEpoch = epoch.fetch_add( 1, std::memory_order_seq_cst) + 1;
+		if( (const addressDictionary *) 0x0 != pOld) {
+			S_DICTIONARY_RETIRED retired = { pOld, retireEpoch };
+			allRetired.push_back( retired);
+		}
+		reclaimLocked();
+
+	}
+
+	// Open a compiled file and make it current
+	bool dictionaryHandle::reload( const char *pFileName) {
+		addressDictionary *pDictionary = new addressDictionary();
+		if( ! pDictionary->open( pFileName)) {
+			std::lock_guard< std::mutex> lock( writerLock);
+			snprintf( acError, sizeof( acError), "%s", pDictionary->getError());
+			delete pDictionary;
+			return( false);
+		}
+		publish( pDictionary);
+		return( true);
+	}
+
+	// Delete the replaced versions no reader can still see
+	size_t dictionaryHandle::reclaim() {
+		std::lock_guard< std::mutex> lock( writerLock);
+		reclaimLocked();
+		return( allRetired.size());
+	}
+
+	// Delete what no reader can see - the lock must be held
+	void dictionaryHandle::reclaimLocked() {
+
+		// The oldest epoch any reader is in
+		uint64_t oldestEpoch = DICTIONARY_READER_IDLE;
+		for( const S_DICTIONARY_READER *pReader : allReaders) {
+			const uint64_t readerEpoch = pReader->epoch.load( std::memory_order_seq_cst);
+			if( readerEpoch < oldestEpoch) oldestEpoch = readerEpoch;
+		}
+
+		// A version retired at or before it was never seen by anyone still reading
+		size_t nKept = 0;
+		for( size_t nRetired = 0; allRetired.size() > nRetired; ++ nRetired) {
+			if( allRetired[nRetired].epoch <= oldestEpoch) delete allRetired[nRetired].pDictionary;
+			else allRetired[nKept ++] = allRetired[nRetired];
+		}
+		allRetired.resize( nKept);
+
+	}
+
+	// Wait until every replaced version is deleted
+	void dictionaryHandle::synchronize() {
+		while( 0 != reclaim()) std::this_thread::yield();
+	}
+
+	// Register a reader
+	S_DICTIONARY_READER * dictionaryHandle::attach() {
+		S_DICTIONARY_READER *pReader = new S_DICTIONARY_READER;
+		pReader->epoch.store( DICTIONARY_READER_IDLE, std::memory_order_relaxed);
+		std::lock_guard< std::mutex> lock( writerLock);
+		allReaders.push_back( pReader);
+		return( pReader);
+	}
+
+	// Remove a reader
+	void dictionaryHandle::detach( S_DICTIONARY_READER *pReader) {
+		std::lock_guard< std::mutex> lock( writerLock);
+		for( size_t nReader = 0; allReaders.size() > nReader; ++ nReader) {
+			if( pReader != allReaders[nReader]) continue;
+			allReaders[nReader] = allReaders.back();
+			allReaders.pop_back();
+			delete pReader;
+			break;
+		}
+		reclaimLocked();
+	}
+
+	// Write one conversion table as a source section
+	static void writeConversionSection( FILE *fOutput, const char *pSection, const S_CONVERSION_TYPE *allTypes) {
+		fprintf( fOutput, "\n[%s]\n", pSection);
+		for( const S_CONVERSION_TYPE *pType = allTypes; (const char *) 0x0 != pType->type; ++ pType) {
+			fprintf( fOutput, "%s, %s\n", pType->type, pType->preftype);
+		}
+	}
+
+	// Write one header list as a source section - the trailing blank is implied
+	static void writeHeaderSection( FILE *fOutput, const char *pSection, const char * const *allHeaders, const char * const *allForms) {
+		fprintf( fOutput, "\n[%s]\n", pSection);
+		for( int nPos = 0; (const char *) 0x0 != allHeaders[nPos]; ++ nPos) {
+			const int headerLen = (int) strlen( allHeaders[nPos]) - 1;
+			fprintf( fOutput, "%.*s, %s\n", headerLen, allHeaders[nPos], ((const char * const *) 0x0 == allForms) ? "PO BOX" : allForms[nPos]);
+		}
+	}
+
+	// Write the built in tables as a text source
+	bool addressDictionary::writeBuiltIn( FILE *fOutput) {
+		fprintf( fOutput, "# The libAddr built in dictionary\n");
+		writeConversionSection( fOutput, DICTIONARY_SECTIONS[DT_STREET_TYPES], addressCompression::KNOWN_STREET_TYPES);
+		writeConversionSection( fOutput, DICTIONARY_SECTIONS[DT_UNIT_TYPES], addressCompression::KNOWN_UNIT_TYPES);
+		writeConversionSection( fOutput, DICTIONARY_SECTIONS[DT_OTHER_CONVERSION], addressCompression::OTHER_CONVERSION);
+		fprintf( fOutput, "\n[%s]\n", DICTIONARY_SECTIONS[DT_DIRECTIONALS]);
+		for( int nPos = 0; (const char *) 0x0 != addressCompression::KNOWN_DIRECTIONALS[nPos]; ++ nPos) {
+			fprintf( fOutput, "%s\n", addressCompression::KNOWN_DIRECTIONALS[nPos]);
+		}
+		writeHeaderSection( fOutput, DICTIONARY_SECTIONS[DT_PO_BOX_HEADERS], addressCompression::KNOWN_PO_BOX_HEADERS, (const char * const *) 0x0);
+		writeHeaderSection( fOutput, DICTIONARY_SECTIONS[DT_RURAL_ROUTE_HEADERS], addressCompression::KNOWN_RURAL_ROUTE_HEADERS, addressCompression::RURAL_ROUTE_FORMS);
+		return( 0 == ferror( fOutput));
+	}
+
+};
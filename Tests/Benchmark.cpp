@@ -0,0 +1,477 @@
+//
+//  Benchmark.cpp
+//  libAddr
+//
+//  This program times each of the parse paths separately over
+//  a generated corpus and reports throughput and latency.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <memory.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+// Hardware counter includes
+#if defined( __linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+// STL includes
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// Project includes
+#include <libAddr.hpp>
+#include <libAddrCorpus.hpp>
+
+// Default sizing
+const size_t DEFAULT_LINES_PER_PATH = 20000;
+const int DEFAULT_REPEATS = 20;
+
+// Longest generated line
+const size_t MAX_BENCH_LINE = MAX_CORPUS_LINE_SIZE;
+
+// The benchmarked paths - every generator path, then a mix of them and normalization
+const int BP_MIXED = libAddr::CP_COUNT;
+const int BP_NORMALIZE = libAddr::CP_COUNT + 1;
+const int BP_COUNT = libAddr::CP_COUNT + 2;
+
+const char * BENCH_PATH_NAMES [] = {
+	"street", "unit after type", "unit before type", "# unit", "po box", "rural route", "numbered highway", "mixed", "normalize", 0x0
+};
+
+//
+// Check a line went down the path it was generated for
+//
+bool tookPath( libAddr::E_CORPUS_PATH ePath, const libAddr::deliveryLine &dl) {
+	switch( ePath) {
+		case libAddr::CP_STREET: return( ('\0' != dl.getStreetType()[0]) && ('\0' == dl.getUnitType()[0]));
+		case libAddr::CP_UNIT_AFTER:
+		case libAddr::CP_UNIT_BEFORE: return( ('\0' != dl.getStreetType()[0]) && ('\0' != dl.getUnitType()[0]));
+		case libAddr::CP_HASH_UNIT: return( 0x0 == strcmp( "UNIT", dl.getUnitType()));
+		case libAddr::CP_PO_BOX: return( '\0' != dl.getPOBox()[0]);
+		case libAddr::CP_RURAL_ROUTE: return( '\0' != dl.getRuralRoute()[0]);
+		case libAddr::CP_HIGHWAY: return( (0x0 != strstr( dl.getStreetName(), "HWY")) && ('\0' == dl.getStreetType()[0]));
+		default: return( false);
+	}
+}
+
+// Monotonic nanoseconds
+inline uint64_t nowNanos( ) {
+	struct timespec tsNow;
+	clock_gettime( CLOCK_MONOTONIC, &tsNow);
+	return( (uint64_t) tsNow.tv_sec * 1000000000ULL + (uint64_t) tsNow.tv_nsec);
+}
+
+// Keeps the optimizer from dropping the work
+volatile size_t nBenchSink = 0;
+
+// Run one line down a path
+inline void runOne( const int nPath, libAddr::deliveryLineParser &parser, libAddr::addressCompression &addrComp,
+					const char *pLine, const size_t lineLen, char *pWork) {
+	if( BP_NORMALIZE == nPath) {
+		nBenchSink += addrComp.normalizeDeliveryLine( pLine, pWork, MAX_BENCH_LINE + 1);
+	}
+	else {
+		nBenchSink += (size_t) parser.parse( pLine, lineLen).getStreetName()[0];
+	}
+}
+
+// Value at a percentile of sorted timings
+uint64_t percentile( const std::vector< uint64_t> &allTimes, const double dPercent) {
+	size_t nIndex = (size_t) (dPercent / 100.0 * (double) (allTimes.size() - 1) + 0.5);
+	return( allTimes[nIndex]);
+}
+
+// The hardware counters
+const int HC_INSTRUCTIONS = 0;
+const int HC_CYCLES = 1;
+const int HC_BRANCHES = 2;
+const int HC_BRANCH_MISSES = 3;
+const int HC_L1D_MISSES = 4;
+const int HC_LLC_MISSES = 5;
+const int HC_COUNT = 6;
+
+const char * HC_NAMES [] = { "instructions", "cycles", "branches", "branch misses", "L1D read misses", "LLC misses", 0x0 };
+
+// The counters of this process in user space, -1 where the counter could not be opened
+struct s_hardware_counters {
+	int allFds [HC_COUNT];
+	double allValues [HC_COUNT];
+};
+typedef struct s_hardware_counters S_HARDWARE_COUNTERS;
+
+//
+// Open the counters - false when none are available, with the reason written
+//
+bool openCounters( S_HARDWARE_COUNTERS &counters) {
+
+	// Nothing is open yet
+	for( int nCounter = 0; HC_COUNT > nCounter; ++ nCounter) {
+		counters.allFds[nCounter] = -1;
+		counters.allValues[nCounter] = -1.0;
+	}
+#if defined( __linux__)
+
+	// Each counter stands alone, so one the processor lacks does not lose the rest
+	const uint32_t allTypes [HC_COUNT] = {
+		PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE
+	};
+	const uint64_t allConfigs [HC_COUNT] = {
+		PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_BRANCH_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES,
+		PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+		PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+	};
+	int nOpened = 0;
+	int nLastError = 0;
+	for( int nCounter = 0; HC_COUNT > nCounter; ++ nCounter) {
+		struct perf_event_attr attr;
+		memset( &attr, 0x0, sizeof( attr));
+		attr.size = sizeof( attr);
+		attr.type = allTypes[nCounter];
+		attr.config = allConfigs[nCounter];
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		counters.allFds[nCounter] = (int) syscall( __NR_perf_event_open, &attr, 0, -1, -1, 0);
+		if( -1 == counters.allFds[nCounter]) nLastError = errno;
+		else ++ nOpened;
+	}
+	if( 0 == nOpened) fprintf( stderr, "Hardware counters are not available: %s\n", strerror( nLastError));
+	return( 0 != nOpened);
+#else
+	fprintf( stderr, "Hardware counters are only read on Linux\n");
+	return( false);
+#endif
+
+}
+
+//
+// Start counting from zero
+//
+void startCounters( S_HARDWARE_COUNTERS &counters) {
+#if defined( __linux__)
+	for( int nCounter = 0; HC_COUNT > nCounter; ++ nCounter) {
+		if( -1 == counters.allFds[nCounter]) continue;
+		ioctl( counters.allFds[nCounter], PERF_EVENT_IOC_RESET, 0);
+		ioctl( counters.allFds[nCounter], PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif
+}
+
+//
+// Stop counting and read the values - scaled up if the kernel shared the counter, -1 if not counted
+//
+void stopCounters( S_HARDWARE_COUNTERS &counters) {
+#if defined( __linux__)
+	for( int nCounter = 0; HC_COUNT > nCounter; ++ nCounter) {
+		counters.allValues[nCounter] = -1.0;
+		if( -1 == counters.allFds[nCounter]) continue;
+		ioctl( counters.allFds[nCounter], PERF_EVENT_IOC_DISABLE, 0);
+		uint64_t allRead [3];
+		if( sizeof( allRead) != read( counters.allFds[nCounter], allRead, sizeof( allRead))) continue;
+		if( 0 == allRead[2]) continue;
+		counters.allValues[nCounter] = (double) allRead[0] * ((double) allRead[1] / (double) allRead[2]);
+	}
+#endif
+}
+
+//
+// Close the counters
+//
+void closeCounters( S_HARDWARE_COUNTERS &counters) {
+	for( int nCounter = 0; HC_COUNT > nCounter; ++ nCounter) {
+		if( -1 != counters.allFds[nCounter]) close( counters.allFds[nCounter]);
+		counters.allFds[nCounter] = -1;
+	}
+}
+
+// Print a ratio, or n/a where either side was not counted
+void printRatio( const double dValue, const double dOver, const double dScale, const char *pFormat) {
+	if( (0.0 > dValue) || (0.0 >= dOver)) printf( " %10s", "n/a");
+	else printf( pFormat, dScale * dValue / dOver);
+}
+
+// The thread scaling APIs - a deliveryLine per line (always the rules engine), or a parser per thread
+const int SA_DELIVERY_LINE = 0;
+const int SA_PARSER = 1;
+const int SA_COUNT = 2;
+
+//
+// Run the whole corpus on some threads at once, and return lines per second
+//
+double runThreads( const int nThreads, const int nApi, const libAddr::E_PARSE_ENGINE engine, const std::vector< char> &allText,
+				   const std::vector< size_t> &allLengths, const int nRepeats) {
+
+	// Every thread waits at the gate, so they all start together
+	std::atomic< int> nReady( 0);
+	std::atomic< bool> bGo( false);
+	std::vector< std::thread> allThreads;
+	std::vector< size_t> allSinks( nThreads, 0);
+	for( int nThread = 0; nThreads > nThread; ++ nThread) {
+		allThreads.emplace_back( [&, nThread]() {
+			libAddr::deliveryLineParser parser;
+			parser.setEngine( engine);
+			size_t nSink = 0;
+			++ nReady;
+			while( ! bGo.load( std::memory_order_acquire)) std::this_thread::yield();
+
+			// Each thread starts at a different place in the corpus
+			const size_t nLines = allLengths.size();
+			for( int nRepeat = 0; nRepeats > nRepeat; ++ nRepeat) {
+				for( size_t nCount = 0; nLines > nCount; ++ nCount) {
+					const size_t nLine = (nCount + (size_t) nThread * nLines / (size_t) nThreads) % nLines;
+					const char *pLine = allText.data() + nLine * (MAX_BENCH_LINE + 1);
+					if( SA_DELIVERY_LINE == nApi) {
+						libAddr::deliveryLine dl( pLine);
+						nSink += (size_t) dl.getStreetName()[0];
+					}
+					else {
+						nSink += (size_t) parser.parse( pLine, allLengths[nLine]).getStreetName()[0];
+					}
+				}
+			}
+			allSinks[nThread] = nSink;
+		});
+	}
+
+	// Open the gate once everyone is waiting, and time until the last finishes
+	while( nThreads > nReady.load()) std::this_thread::yield();
+	const uint64_t nStart = nowNanos();
+	bGo.store( true, std::memory_order_release);
+	for( std::thread &thread : allThreads) thread.join();
+	const uint64_t nElapsed = nowNanos() - nStart;
+	for( const size_t nSink : allSinks) nBenchSink += nSink;
+	return( ((double) allLengths.size() * (double) nRepeats * (double) nThreads) * 1.0e9 / (double) nElapsed);
+
+}
+
+//
+// Thread scaling - the mixed corpus on 1, 2, 4 ... threads
+//
+void runScaling( const int nMaxThreads, const size_t nLines, const int nRepeats, const libAddr::E_PARSE_ENGINE engine) {
+
+	// Build the corpus once, shared read only by every thread
+	std::vector< char> allText( nLines * (MAX_BENCH_LINE + 1));
+	std::vector< size_t> allLengths( nLines);
+	libAddr::S_CORPUS_OPTIONS corpusOptions;
+	libAddr::corpusGenerator::defaultOptions( corpusOptions);
+	libAddr::corpusGenerator generator( corpusOptions);
+	for( size_t nLine = 0; nLines > nLine; ++ nLine)
+		allLengths[nLine] = generator.nextLine( allText.data() + nLine * (MAX_BENCH_LINE + 1), MAX_BENCH_LINE + 1);
+
+	// Powers of two, then the maximum itself
+	std::vector< int> allCounts;
+	for( int nThreads = 1; nMaxThreads > nThreads; nThreads *= 2) allCounts.push_back( nThreads);
+	allCounts.push_back( nMaxThreads);
+
+	printf( "%zu mixed lines, %d repeats, %s engine, up to %d threads (%u cores)\n\n", nLines, nRepeats,
+		(libAddr::PE_STATE_MACHINE == engine) ? "state machine" : "rules", nMaxThreads, std::thread::hardware_concurrency());
+	printf( "%-8s %16s %10s %16s %10s\n", "Threads", "deliveryLine/sec", "scaling", "parser/sec", "scaling");
+	printf( "%-8s %16s %10s %16s %10s\n", "-------", "----------------", "-------", "----------", "-------");
+
+	// Efficiency is the rate against one thread's rate times the thread count
+	double allSingle [SA_COUNT] = { 0.0, 0.0 };
+	for( const int nThreads : allCounts) {
+		double allRates [SA_COUNT];
+		for( int nApi = 0; SA_COUNT > nApi; ++ nApi) {
+			allRates[nApi] = runThreads( nThreads, nApi, engine, allText, allLengths, nRepeats);
+			if( 1 == nThreads) allSingle[nApi] = allRates[nApi];
+		}
+		printf( "%-8d %16.0f %9.1f%% %16.0f %9.1f%%\n", nThreads,
+			allRates[SA_DELIVERY_LINE], 100.0 * allRates[SA_DELIVERY_LINE] / (allSingle[SA_DELIVERY_LINE] * (double) nThreads),
+			allRates[SA_PARSER], 100.0 * allRates[SA_PARSER] / (allSingle[SA_PARSER] * (double) nThreads));
+	}
+
+}
+
+//
+// Usage
+//
+void usage( const char *pProgram) {
+	fprintf( stderr, "Usage: %s [-n lines per path] [-r repeats] [-m] [-p] [-t threads]\n", pProgram);
+	fprintf( stderr, "  -m  parse with the state machine engine\n");
+	fprintf( stderr, "  -p  read the hardware performance counters for each path\n");
+	fprintf( stderr, "  -t  thread scaling up to this many threads, 0 for one per core\n");
+}
+
+//////////
+// MAIN //
+//////////
+
+int main( int argc, char **argv) {
+
+	// Options
+	size_t nLines = DEFAULT_LINES_PER_PATH;
+	int nRepeats = DEFAULT_REPEATS;
+	libAddr::E_PARSE_ENGINE engine = libAddr::PE_RULES;
+	int nMaxThreads = -1;
+	bool bCounters = false;
+	int nOpt;
+	while( -1 != (nOpt = getopt( argc, argv, "n:r:mpt:"))) {
+		switch( nOpt) {
+			case 'n': nLines = (size_t) atol( optarg); break;
+			case 'r': nRepeats = atoi( optarg); break;
+			case 'm': engine = libAddr::PE_STATE_MACHINE; break;
+			case 'p': bCounters = true; break;
+			case 't': nMaxThreads = atoi( optarg); break;
+			default: usage( argv[0]); return( EXIT_FAILURE);
+		}
+	}
+	if( (0 == nLines) || (0 >= nRepeats)) {
+		usage( argv[0]);
+		return( EXIT_FAILURE);
+	}
+
+	// Thread scaling instead of the paths
+	if( -1 != nMaxThreads) {
+		if( 0 == nMaxThreads) nMaxThreads = (int) std::thread::hardware_concurrency();
+		if( 0 >= nMaxThreads) {
+			usage( argv[0]);
+			return( EXIT_FAILURE);
+		}
+		runScaling( nMaxThreads, nLines, nRepeats, engine);
+		return( EXIT_SUCCESS);
+	}
+
+	// Timer overhead, so the latency columns can be read against it
+	std::vector< uint64_t> allTimes( nLines);
+	for( size_t nTime = 0; nLines > nTime; ++ nTime) {
+		uint64_t nStart = nowNanos();
+		allTimes[nTime] = nowNanos() - nStart;
+	}
+	std::sort( allTimes.begin(), allTimes.end());
+	printf( "%zu lines per path, %d repeats, %s engine, timer overhead p50 %llu ns\n\n", nLines, nRepeats,
+		(libAddr::PE_STATE_MACHINE == engine) ? "state machine" : "rules", (unsigned long long) percentile( allTimes, 50.0));
+	printf( "%-18s %10s %12s %8s %8s %8s\n", "Path", "ns/line", "lines/sec", "p50", "p99", "p99.9");
+	printf( "%-18s %10s %12s %8s %8s %8s\n", "----", "-------", "---------", "---", "---", "-----");
+
+	libAddr::deliveryLineParser parser;
+	parser.setEngine( engine);
+	libAddr::addressCompression addrComp;
+	std::vector< char> allText( nLines * (MAX_BENCH_LINE + 1));
+	std::vector< size_t> allLengths( nLines);
+	char acWork [MAX_BENCH_LINE + 1];
+	int nMisrouted = 0;
+	libAddr::deliveryLine::resetStatistics();
+
+	// Hardware counters, when asked for and available
+	S_HARDWARE_COUNTERS counters;
+	double allPathCounts [BP_COUNT][HC_COUNT];
+	if( bCounters) bCounters = openCounters( counters);
+
+	for( int nPath = 0; BP_COUNT > nPath; ++ nPath) {
+
+		// Build the corpus - one path alone, or the default mix
+		libAddr::S_CORPUS_OPTIONS corpusOptions;
+		libAddr::corpusGenerator::defaultOptions( corpusOptions);
+		corpusOptions.seed = (uint64_t) nPath + 1;
+		if( BP_MIXED != nPath) {
+			memset( corpusOptions.pathWeight, 0, sizeof( corpusOptions.pathWeight));
+			corpusOptions.pathWeight[(BP_NORMALIZE == nPath) ? libAddr::CP_STREET : nPath] = 1;
+		}
+		libAddr::corpusGenerator generator( corpusOptions);
+		for( size_t nLine = 0; nLines > nLine; ++ nLine) {
+			char *pLine = allText.data() + nLine * (MAX_BENCH_LINE + 1);
+			allLengths[nLine] = generator.nextLine( pLine, MAX_BENCH_LINE + 1);
+			if( ! tookPath( generator.getLastPath(), parser.parse( pLine, allLengths[nLine]))) {
+				if( 0 == nMisrouted ++) fprintf( stderr, "Line did not take the %s path: %s\n", BENCH_PATH_NAMES[nPath], pLine);
+			}
+		}
+
+		// Throughput over the whole corpus
+		if( bCounters) startCounters( counters);
+		uint64_t nStart = nowNanos();
+		for( int nRepeat = 0; nRepeats > nRepeat; ++ nRepeat) {
+			for( size_t nLine = 0; nLines > nLine; ++ nLine)
+				runOne( nPath, parser, addrComp, allText.data() + nLine * (MAX_BENCH_LINE + 1), allLengths[nLine], acWork);
+		}
+		const double dNanosPerLine = (double) (nowNanos() - nStart) / ((double) nLines * (double) nRepeats);
+		if( bCounters) {
+			stopCounters( counters);
+			memcpy( allPathCounts[nPath], counters.allValues, sizeof( allPathCounts[nPath]));
+		}
+
+		// Latency per line
+		for( size_t nLine = 0; nLines > nLine; ++ nLine) {
+			const char *pLine = allText.data() + nLine * (MAX_BENCH_LINE + 1);
+			uint64_t nLineStart = nowNanos();
+			runOne( nPath, parser, addrComp, pLine, allLengths[nLine], acWork);
+			allTimes[nLine] = nowNanos() - nLineStart;
+		}
+		std::sort( allTimes.begin(), allTimes.end());
+
+		printf( "%-18s %10.1f %12.0f %8llu %8llu %8llu\n", BENCH_PATH_NAMES[nPath], dNanosPerLine, 1.0e9 / dNanosPerLine,
+			(unsigned long long) percentile( allTimes, 50.0), (unsigned long long) percentile( allTimes, 99.0),
+			(unsigned long long) percentile( allTimes, 99.9));
+
+	}
+
+	// Per line hardware counts for each path
+	if( bCounters) {
+		closeCounters( counters);
+		printf( "\n%-18s %10s %10s %10s %10s %10s %10s\n", "Path", "insns/line", "IPC", "br miss %", "miss/line", "L1D/line", "LLC/line");
+		printf( "%-18s %10s %10s %10s %10s %10s %10s\n", "----", "----------", "---", "---------", "---------", "--------", "--------");
+		const double dLines = (double) nLines * (double) nRepeats;
+		for( int nPath = 0; BP_COUNT > nPath; ++ nPath) {
+			const double *pCounts = allPathCounts[nPath];
+			printf( "%-18s", BENCH_PATH_NAMES[nPath]);
+			printRatio( pCounts[HC_INSTRUCTIONS], dLines, 1.0, " %10.1f");
+			printRatio( pCounts[HC_INSTRUCTIONS], pCounts[HC_CYCLES], 1.0, " %10.2f");
+			printRatio( pCounts[HC_BRANCH_MISSES], pCounts[HC_BRANCHES], 100.0, " %9.2f%%");
+			printRatio( pCounts[HC_BRANCH_MISSES], dLines, 1.0, " %10.2f");
+			printRatio( pCounts[HC_L1D_MISSES], dLines, 1.0, " %10.2f");
+			printRatio( pCounts[HC_LLC_MISSES], dLines, 1.0, " %10.3f");
+			printf( "\n");
+		}
+		for( int nCounter = 0; HC_COUNT > nCounter; ++ nCounter) {
+			if( 0.0 > allPathCounts[0][nCounter]) printf( "The %s counter is not available\n", HC_NAMES[nCounter]);
+		}
+	}
+
+	// Where the time went, when the counters are built in
+	if( libAddr::deliveryLine::isInstrumented()) {
+		printf( "\n");
+		libAddr::deliveryLine::statisticsDump( stdout);
+	}
+
+	if( 0 != nMisrouted) fprintf( stderr, "\n%d generated lines did not take their path\n", nMisrouted);
+	return( EXIT_SUCCESS);
+
+}
@@ -41,9 +41,22 @@
 #include <unistd.h>
 #include <memory.h>
 #include <string.h>
+#include <ctype.h>
+
+// STL includes
+#include <atomic>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
 
 // Project includes
 #include <libAddr.hpp>
+#include <libAddrArena.hpp>
+#include <libAddrCache.hpp>
+#include <libAddrColumns.hpp>
+#include <libAddrCorpus.hpp>
+#include <libAddrDictionary.hpp>
 
 // The structure of the known results
 struct s_known_output {
@@ -80,6 +93,18 @@ const char * TEST_ADDR [] = {
 	"Rural Rte 5 # 332",
 	"Rural Rte 5 #332",
 	"Rural Rte 5#332",
+	"PO Box 123",
+	"P.O.  Box 77, Dept 5",
+	"rural\troute 4 box 9 rear",
+	"1200 -  Main St. , Apt. 4",
+	"5397 Cedar Lake Apt Road",
+	"Apt 5 Road",
+	"P O Box 12",
+	"Post Office Box 9",
+	"HC 3 Box 15",
+	"Hcr 3 Box 15",
+	"PSC 1234 Box 5678",
+	"CMR 450 Box 12",
 	0x0
 };
 
@@ -102,10 +127,145 @@ const S_KNOWN_OUTPUT TEST_OUTPUTS [] = {
 	{ "" , "" , "" , "" , "" , "" , "" , "" , "RURAL ROUTE 5 BOX 332" , "" },
 	{ "" , "" , "" , "" , "" , "" , "" , "" , "RURAL ROUTE 5 BOX 332" , "" },
 	{ "" , "" , "" , "" , "" , "" , "" , "" , "RURAL ROUTE 5 BOX 332" , "" },
+	{ "" , "" , "" , "" , "" , "" , "" , "PO BOX 123" , "" , "" },
+	{ "" , "" , "" , "" , "" , "" , "" , "PO BOX 77" , "" , "DEPT 5" },
+	{ "" , "" , "" , "" , "" , "" , "" , "" , "RURAL ROUTE 4 BOX 9" , "REAR" },
+	{ "1200" , "" , "MAIN" , "ST" , "" , "APT" , "4" , "" , "" , "" },
+	{ "5397" , "" , "CEDAR LAKE" , "RD" , "" , "APT" , "" , "" , "" , "" },
+	{ "" , "" , "" , "RD" , "" , "APT" , "5" , "" , "" , "" },
+	{ "" , "" , "" , "" , "" , "" , "" , "PO BOX 12" , "" , "" },
+	{ "" , "" , "" , "" , "" , "" , "" , "PO BOX 9" , "" , "" },
+	{ "" , "" , "" , "" , "" , "" , "" , "" , "HC 3 BOX 15" , "" },
+	{ "" , "" , "" , "" , "" , "" , "" , "" , "HC 3 BOX 15" , "" },
+	{ "" , "" , "" , "" , "" , "" , "" , "" , "PSC 1234 BOX 5678" , "" },
+	{ "" , "" , "" , "" , "" , "" , "" , "" , "CMR 450 BOX 12" , "" },
 	{ "" , "" , "" , "" , "" , "" , "" , "" , "" , "" }
 
 };
 
+// Count heap allocations so steady state parsing can be checked
+std::atomic<long> nHeapAllocations( 0);
+void * operator new( size_t nBytes) {
+	++ nHeapAllocations;
+	void *pMem = malloc( nBytes ? nBytes : 1);
+	if( (void *) 0x0 == pMem) throw std::bad_alloc();
+	return( pMem);
+}
+void operator delete( void *pMem) noexcept { free( pMem); }
+void operator delete( void *pMem, size_t) noexcept { free( pMem); }
+
+// Stress test sizing
+const int STRESS_THREADS = 8;
+const int STRESS_ITERATIONS = 2000;
+const int STRESS_MAX_INPUTS = 32;
+
+// Normalized lines from the last stress iteration of every thread
+char acStressNormalized [STRESS_THREADS][STRESS_MAX_INPUTS][4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
+
+// Compare a parsed line (or view) against the known output
+template< class T_LINE>
+bool matchesKnownOutput( const T_LINE &dl, const S_KNOWN_OUTPUT *testOutput) {
+	bool bThisPassed = true;
+	bThisPassed &= (0x0 == strcmp( testOutput->pStreetNumber,		dl.getStreetNumber()));
+	bThisPassed &= (0x0 == strcmp( testOutput->pPreDirectional,		dl.getPreDirectional()));
+	bThisPassed &= (0x0 == strcmp( testOutput->pStreetName,			dl.getStreetName()));
+	bThisPassed &= (0x0 == strcmp( testOutput->pStreetType,			dl.getStreetType()));
+	bThisPassed &= (0x0 == strcmp( testOutput->pPostDirectional,	dl.getPostDirectional()));
+	bThisPassed &= (0x0 == strcmp( testOutput->pUnitType,			dl.getUnitType()));
+	bThisPassed &= (0x0 == strcmp( testOutput->pUnitNumber,			dl.getUnitNumber()));
+	bThisPassed &= (0x0 == strcmp( testOutput->pPOBox,				dl.getPOBox()));
+	bThisPassed &= (0x0 == strcmp( testOutput->pRuralRoute,			dl.getRuralRoute()));
+	bThisPassed &= (0x0 == strcmp( testOutput->pRemainder,			dl.getRemainder()));
+	return( bThisPassed);
+}
+
+// Parse and normalize every known input from many threads at once
+// Nothing is parsed before the threads start, so first use races too
+int runThreadStress( ) {
+
+	std::atomic<bool> bStart( false);
+	std::atomic<int> nFailures( 0);
+	std::vector<std::thread> allThreads;
+
+	for( int nThread = 0; STRESS_THREADS > nThread; ++ nThread) {
+		allThreads.push_back( std::thread( [&bStart, &nFailures, nThread]( ) {
+			while( ! bStart.load()) std::this_thread::yield();
+			for( int nIter = 0; STRESS_ITERATIONS > nIter; ++ nIter) {
+				for( int nPos = 0; (STRESS_MAX_INPUTS > nPos) && ((const char *) 0x0 != TEST_ADDR [nPos]); ++ nPos) {
+					libAddr::deliveryLine dl( TEST_ADDR [nPos]);
+					if( ! matchesKnownOutput( dl, TEST_OUTPUTS + nPos)) ++ nFailures;
+					char *normLine = acStressNormalized [nThread][nPos];
+					strncpy( normLine, TEST_ADDR [nPos], sizeof( acStressNormalized [nThread][nPos]) - 1);
+					libAddr::addressCompression addrComp;
+					addrComp.normalizeDeliveryLine( normLine, sizeof( acStressNormalized [nThread][nPos]));
+				}
+			}
+		}));
+	}
+	bStart.store( true);
+	for( std::thread &thread : allThreads) thread.join();
+
+	// Every thread must normalize exactly as a lone thread does
+	for( int nPos = 0; (STRESS_MAX_INPUTS > nPos) && ((const char *) 0x0 != TEST_ADDR [nPos]); ++ nPos) {
+		char normLine [4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
+		memset( normLine, 0x0, sizeof( normLine));
+		strncpy( normLine, TEST_ADDR [nPos], sizeof( normLine) - 1);
+		libAddr::addressCompression addrComp;
+		addrComp.normalizeDeliveryLine( normLine, sizeof( normLine));
+		for( int nThread = 0; STRESS_THREADS > nThread; ++ nThread) {
+			if( 0x0 != strcmp( normLine, acStressNormalized [nThread][nPos])) ++ nFailures;
+		}
+	}
+
+	return( nFailures.load());
+
+}
+
+//
+// Parse on several threads while the dictionary is reloaded under them
+// Returns the number of failures
+//
+int runReloadStress( libAddr::dictionaryHandle &handle, const char *pFirstFile, const char *pSecondFile) {
+
+	std::atomic<bool> bStop( false);
+	std::atomic<int> nFailures( 0);
+	std::vector<std::thread> allThreads;
+	for( int nThread = 0; STRESS_THREADS > nThread; ++ nThread) {
+		allThreads.push_back( std::thread( [&handle, &bStop, &nFailures]( ) {
+			libAddr::deliveryLineParser parser;
+			parser.setDictionaryHandle( &handle);
+			while( ! bStop.load()) {
+
+				// Both versions hold the built in tables
+				for( int nPos = 0; (STRESS_MAX_INPUTS > nPos) && ((const char *) 0x0 != TEST_ADDR [nPos]); ++ nPos) {
+					if( ! matchesKnownOutput( parser.parse( TEST_ADDR [nPos], strlen( TEST_ADDR [nPos])), TEST_OUTPUTS + nPos)) ++ nFailures;
+				}
+
+				// Only one knows FOOWAY - either answer is right, but never a mix
+				const libAddr::deliveryLine &dl = parser.parse( "123 Main Fooway", 15);
+				const bool bCustom = (0x0 == strcmp( "FWY", dl.getStreetType())) && (0x0 == strcmp( "MAIN", dl.getStreetName()));
+				const bool bBuiltIn = (0x0 == dl.getStreetName()[0]) && (0x0 == strcmp( "123 MAIN FOOWAY", dl.getRemainder()));
+				if( ! bCustom && ! bBuiltIn) ++ nFailures;
+
+			}
+		}));
+	}
+
+	// Flip between the two
+	for( int nReload = 0; 200 > nReload; ++ nReload) {
+		if( ! handle.reload( (0 == (nReload % 2)) ? pFirstFile : pSecondFile)) ++ nFailures;
+		std::this_thread::yield();
+	}
+	bStop.store( true);
+	for( std::thread &thread : allThreads) thread.join();
+
+	// With the readers gone, nothing may be left waiting
+	if( 0 != handle.reclaim()) ++ nFailures;
+	if( 200 != handle.getVersion()) ++ nFailures;
+	return( nFailures.load());
+
+}
+
 //////////
 // MAIN //
 //////////
@@ -121,6 +281,17 @@ int main( int argc, char **argv) {
 	int nPassed = 0;
 	int nPos = 0;
 
+	// Run the thread stress first so it sees a cold library
+	int nStressFailed = runThreadStress();
+	if( 0 != nStressFailed) {
+		printf( "FAILURE for thread stress ===== %d mismatched parses =====\n", nStressFailed);
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
 	// Loop over all of the input until the empty string is returned
 	for( ; (const char *) 0x0 != TEST_ADDR [nPos] ; ++ nPos) {
 
@@ -132,17 +303,7 @@ int main( int argc, char **argv) {
 		libAddr::deliveryLine dl( testInput);
 
 		// Validate
-		bool bThisPassed = true;
-		bThisPassed &= (0x0 == strcmp( testOutput->pStreetNumber,		dl.getStreetNumber()));
-		bThisPassed &= (0x0 == strcmp( testOutput->pPreDirectional,		dl.getPreDirectional()));
-		bThisPassed &= (0x0 == strcmp( testOutput->pStreetName,			dl.getStreetName()));
-		bThisPassed &= (0x0 == strcmp( testOutput->pStreetType,			dl.getStreetType()));
-		bThisPassed &= (0x0 == strcmp( testOutput->pPostDirectional,	dl.getPostDirectional()));
-		bThisPassed &= (0x0 == strcmp( testOutput->pUnitType,			dl.getUnitType()));
-		bThisPassed &= (0x0 == strcmp( testOutput->pUnitNumber,			dl.getUnitNumber()));
-		bThisPassed &= (0x0 == strcmp( testOutput->pPOBox,				dl.getPOBox()));
-		bThisPassed &= (0x0 == strcmp( testOutput->pRuralRoute,			dl.getRuralRoute()));
-		bThisPassed &= (0x0 == strcmp( testOutput->pRemainder,			dl.getRemainder()));
+		bool bThisPassed = matchesKnownOutput( dl, testOutput);
 		bAllPassed &= bThisPassed;
 		if(bThisPassed) {
 			++ nPassed;
@@ -167,6 +328,676 @@ int main( int argc, char **argv) {
 
 	}
 
+	// Dictionary access for the checks below
+	libAddr::addressCompression addrComp;
+
+	// One parser reused over every input, forwards and backwards
+	// Inputs are given with a length and trailing junk so nothing relies on the terminator
+	libAddr::deliveryLineParser parser;
+	int nParserFailed = 0;
+	long nAllocsBefore = nHeapAllocations.load();
+	for( int nPass = 0; 2 > nPass; ++ nPass) {
+		for( int nStep = 0; nPos > nStep; ++ nStep) {
+			int nInput = (0 == nPass) ? nStep : (nPos - 1 - nStep);
+			char acPadded [4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 16];
+			size_t nLen = strlen( TEST_ADDR [nInput]);
+			memcpy( acPadded, TEST_ADDR [nInput], nLen);
+			strcpy( acPadded + nLen, " JUNK 99");
+			if( ! matchesKnownOutput( parser.parse( acPadded, nLen), TEST_OUTPUTS + nInput)) {
+				printf( "FAILURE for reused parser ===== %s =====\n", TEST_ADDR [nInput]);
+				++ nParserFailed;
+			}
+		}
+	}
+	if( nAllocsBefore != nHeapAllocations.load()) {
+		printf( "FAILURE for reused parser ===== %ld heap allocations =====\n", nHeapAllocations.load() - nAllocsBefore);
+		++ nParserFailed;
+	}
+	if( 0 != nParserFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// The state machine engine gives the known outputs, and the same results as the rules on a generated corpus
+	int nMachineFailed = 0;
+	libAddr::deliveryLineParser machineParser;
+	machineParser.setEngine( libAddr::PE_STATE_MACHINE);
+	for( int nInput = 0; nPos > nInput; ++ nInput) {
+		if( ! matchesKnownOutput( machineParser.parse( TEST_ADDR [nInput], strlen( TEST_ADDR [nInput])), TEST_OUTPUTS + nInput)) {
+			printf( "FAILURE for state machine ===== %s =====\n", TEST_ADDR [nInput]);
+			++ nMachineFailed;
+		}
+	}
+	libAddr::S_CORPUS_OPTIONS machineOptions;
+	libAddr::corpusGenerator::defaultOptions( machineOptions);
+	machineOptions.punctuationPercent = 20;
+	libAddr::corpusGenerator machineGenerator( machineOptions);
+	for( int nLine = 0; 20000 > nLine; ++ nLine) {
+		char acLine [MAX_CORPUS_LINE_SIZE + 1];
+		const size_t lineLen = machineGenerator.nextLine( acLine, sizeof( acLine));
+		const libAddr::deliveryLine &dl = parser.parse( acLine, lineLen);
+		const S_KNOWN_OUTPUT rulesOutput = {
+			dl.getStreetNumber(), dl.getPreDirectional(), dl.getStreetName(), dl.getStreetType(), dl.getPostDirectional(),
+			dl.getUnitType(), dl.getUnitNumber(), dl.getPOBox(), dl.getRuralRoute(), dl.getRemainder()
+		};
+		if( ! matchesKnownOutput( machineParser.parse( acLine, lineLen), &rulesOutput)) {
+			printf( "FAILURE for state machine ===== %s =====\n", acLine);
+			++ nMachineFailed;
+		}
+	}
+	if( 0 != nMachineFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// Batch parsing - as an array of lines and as one newline delimited buffer
+	int nBatchFailed = 0;
+	char acBuffer [STRESS_MAX_INPUTS * (4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1)];
+	size_t lineOffsets [STRESS_MAX_INPUTS + 1];
+	size_t nBufferLen = 0;
+	for( int nInput = 0; nPos > nInput; ++ nInput) {
+		lineOffsets[nInput] = nBufferLen;
+		nBufferLen += sprintf( acBuffer + nBufferLen, "%s%s", TEST_ADDR [nInput], (nInput & 1) ? "\r\n" : "\n");
+	}
+	lineOffsets[nPos] = nBufferLen;
+	std::vector<libAddr::deliveryLine> fromArray( nPos);
+	std::vector<libAddr::deliveryLine> fromBuffer( nPos);
+	nBatchFailed += ((size_t) nPos != parser.parseBatch( TEST_ADDR, nPos, fromArray.data())) ? 1 : 0;
+	nBatchFailed += ((size_t) nPos != parser.parseBatch( acBuffer, lineOffsets, nPos, fromBuffer.data())) ? 1 : 0;
+	for( int nInput = 0; nPos > nInput; ++ nInput) {
+		if( (! matchesKnownOutput( fromArray[nInput], TEST_OUTPUTS + nInput)) || (! matchesKnownOutput( fromBuffer[nInput], TEST_OUTPUTS + nInput))) {
+			printf( "FAILURE for batch parse ===== %s =====\n", TEST_ADDR [nInput]);
+			++ nBatchFailed;
+		}
+	}
+	if( 0 != nBatchFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// Compact views packed one after another into a single text buffer
+	int nViewFailed = 0;
+	std::vector<libAddr::deliveryLineView> allViews( nPos);
+	size_t nTextUsed = 0;
+	for( int nInput = 0; nPos > nInput; ++ nInput) {
+		size_t nUsed = parser.parse( TEST_ADDR [nInput], strlen( TEST_ADDR [nInput]), allViews[nInput], acBuffer + nTextUsed, sizeof( acBuffer) - nTextUsed);
+		if( 0 == nUsed) ++ nViewFailed;
+		nTextUsed += nUsed;
+	}
+	for( int nInput = 0; nPos > nInput; ++ nInput) {
+		const libAddr::deliveryLineView &view = allViews[nInput];
+		bool bThisPassed = matchesKnownOutput( view, TEST_OUTPUTS + nInput);
+		if( 0x0 != view.getStreetType()[0]) bThisPassed &= (addrComp.lookupStreetType( view.getStreetType())->preftype == view.getStreetType());
+		if( ! bThisPassed) {
+			printf( "FAILURE for compact view ===== %s =====\n", TEST_ADDR [nInput]);
+			++ nViewFailed;
+		}
+	}
+	libAddr::deliveryLineView tooSmall;
+	if( 0 != parser.parse( TEST_ADDR [0], strlen( TEST_ADDR [0]), tooSmall, acBuffer, 4)) ++ nViewFailed;
+	if( 0x0 != tooSmall.getStreetName()[0]) ++ nViewFailed;
+	if( 0 != nViewFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// Every dictionary entry must be found through its own key
+	int nLookupFailed = 0;
+	for( int nST = 0; (const char *) 0x0 != libAddr::addressCompression::KNOWN_STREET_TYPES[nST].type; ++ nST) {
+		if( libAddr::addressCompression::KNOWN_STREET_TYPES + nST != addrComp.lookupStreetType( libAddr::addressCompression::KNOWN_STREET_TYPES[nST].type)) {
+			printf( "FAILURE for street type lookup ===== %s =====\n", libAddr::addressCompression::KNOWN_STREET_TYPES[nST].type);
+			++ nLookupFailed;
+		}
+	}
+	for( int nUT = 0; (const char *) 0x0 != libAddr::addressCompression::KNOWN_UNIT_TYPES[nUT].type; ++ nUT) {
+		if( libAddr::addressCompression::KNOWN_UNIT_TYPES + nUT != addrComp.lookupUnitType( libAddr::addressCompression::KNOWN_UNIT_TYPES[nUT].type)) {
+			printf( "FAILURE for unit type lookup ===== %s =====\n", libAddr::addressCompression::KNOWN_UNIT_TYPES[nUT].type);
+			++ nLookupFailed;
+		}
+	}
+	for( int nOT = 0; (const char *) 0x0 != libAddr::addressCompression::OTHER_CONVERSION[nOT].type; ++ nOT) {
+		if( libAddr::addressCompression::OTHER_CONVERSION + nOT != addrComp.lookupOtherConversion( libAddr::addressCompression::OTHER_CONVERSION[nOT].type)) {
+			printf( "FAILURE for other conversion lookup ===== %s =====\n", libAddr::addressCompression::OTHER_CONVERSION[nOT].type);
+			++ nLookupFailed;
+		}
+	}
+
+	// And near misses must not be found
+	const char * NOT_FOUND [] = { "", "A", "AVENUES", "STREETZ", "RDD", "APTS", "10TH", "CEDAR", 0x0 };
+	for( int nNF = 0; (const char *) 0x0 != NOT_FOUND[nNF]; ++ nNF) {
+		if( ((const libAddr::S_CONVERSION_TYPE *) 0x0 != addrComp.lookupStreetType( NOT_FOUND[nNF])) ||
+		   	((const libAddr::S_CONVERSION_TYPE *) 0x0 != addrComp.lookupUnitType( NOT_FOUND[nNF])) ||
+		   	((const libAddr::S_CONVERSION_TYPE *) 0x0 != addrComp.lookupOtherConversion( NOT_FOUND[nNF]))) {
+			printf( "FAILURE for unknown lookup ===== %s =====\n", NOT_FOUND[nNF]);
+			++ nLookupFailed;
+		}
+	}
+	if( 0 != nLookupFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// Cached parses and normalizations match the uncached ones, and the second pass hits
+	int nCacheFailed = 0;
+	libAddr::deliveryLineCache cache( 1 << 20);
+	for( int nPass = 0; 2 > nPass; ++ nPass) {
+		for( int nInput = 0; nPos > nInput; ++ nInput) {
+			if( ! matchesKnownOutput( cache.parse( parser, TEST_ADDR [nInput], strlen( TEST_ADDR [nInput])), TEST_OUTPUTS + nInput)) {
+				printf( "FAILURE for cached parse ===== %s =====\n", TEST_ADDR [nInput]);
+				++ nCacheFailed;
+			}
+			char acDirect [4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
+			char acCached [4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
+			memset( acDirect, 0x0, sizeof( acDirect));
+			strncpy( acDirect, TEST_ADDR [nInput], sizeof( acDirect) - 1);
+			memcpy( acCached, acDirect, sizeof( acCached));
+			const size_t directLen = addrComp.normalizeDeliveryLine( acDirect, sizeof( acDirect));
+			const size_t cachedLen = cache.normalizeDeliveryLine( parser, acCached, sizeof( acCached));
+			if( (directLen != cachedLen) || (0x0 != memcmp( acDirect, acCached, sizeof( acDirect)))) {
+				printf( "FAILURE for cached normalize ===== %s =====\n", TEST_ADDR [nInput]);
+				++ nCacheFailed;
+			}
+		}
+	}
+	libAddr::S_CACHE_STATISTICS cacheStatistics;
+	cache.getStatistics( cacheStatistics);
+	if( ((uint64_t) (2 * nPos) > cacheStatistics.hits) || (cacheStatistics.hits + cacheStatistics.misses != (uint64_t) (4 * nPos))) ++ nCacheFailed;
+
+	// A tiny cache must evict to stay under its cap
+	libAddr::deliveryLineCache tinyCache( 2048, 1);
+	for( int nInput = 0; nPos > nInput; ++ nInput) tinyCache.parse( parser, TEST_ADDR [nInput], strlen( TEST_ADDR [nInput]));
+	tinyCache.getStatistics( cacheStatistics);
+	if( (0 == cacheStatistics.evictions) || (cacheStatistics.bytesLimit < cacheStatistics.bytesUsed)) ++ nCacheFailed;
+	if( 0 != nCacheFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// Normalizing into a separate buffer matches normalizing in place and leaves the input alone
+	int nNormalizeFailed = 0;
+	for( int nInput = 0; nPos > nInput; ++ nInput) {
+		char acInPlace [4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
+		char acOutput [4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
+		char acShort [8];
+		strncpy( acInPlace, TEST_ADDR [nInput], sizeof( acInPlace) - 1);
+		acInPlace[sizeof( acInPlace) - 1] = 0x0;
+		const size_t inPlaceLen = addrComp.normalizeDeliveryLine( acInPlace, sizeof( acInPlace));
+		const size_t outputLen = addrComp.normalizeDeliveryLine( TEST_ADDR [nInput], acOutput, sizeof( acOutput));
+		const size_t shortLen = addrComp.normalizeDeliveryLine( TEST_ADDR [nInput], acShort, sizeof( acShort));
+		if( (inPlaceLen != outputLen) || (inPlaceLen != strlen( acInPlace)) || (0x0 != strcmp( acInPlace, acOutput))) {
+			printf( "FAILURE for normalize to buffer ===== %s =====\n", TEST_ADDR [nInput]);
+			++ nNormalizeFailed;
+		}
+		if( (strlen( acShort) != shortLen) || (sizeof( acShort) <= shortLen) || (0x0 != strncmp( acShort, acOutput, shortLen))) {
+			printf( "FAILURE for short normalize ===== %s =====\n", TEST_ADDR [nInput]);
+			++ nNormalizeFailed;
+		}
+	}
+	if( 0 != nNormalizeFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// Batch normalizing matches normalizing each line, and repeats are only normalized once
+	int nBatchNormalizeFailed = 0;
+	const size_t BATCH_LINE_SIZE = 4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1;
+	std::vector< std::string> batchInputs;
+	for( int nInput = 0; nPos > nInput; ++ nInput) {
+		std::string lowered( TEST_ADDR [nInput]);
+		for( char &cValue : lowered) cValue = (char) tolower( cValue);
+		batchInputs.push_back( TEST_ADDR [nInput]);
+		batchInputs.push_back( lowered + ".");
+		batchInputs.push_back( TEST_ADDR [nInput]);
+	}
+	std::vector< const char *> batchLines;
+	for( const std::string &input : batchInputs) batchLines.push_back( input.c_str());
+	batchLines.push_back( (const char *) 0x0);
+	batchLines.push_back( "");
+	batchLines.push_back( (const char *) 0x0);
+	std::vector< char> batchOutput( batchLines.size() * BATCH_LINE_SIZE);
+	std::vector< size_t> batchLengths( batchLines.size());
+	const size_t nDistinct = parser.normalizeBatch( batchLines.data(), batchLines.size(), batchOutput.data(), BATCH_LINE_SIZE, batchLengths.data());
+	if( (0 == nDistinct) || ((size_t) nPos < nDistinct)) ++ nBatchNormalizeFailed;
+	for( size_t nLine = 0; batchLines.size() > nLine; ++ nLine) {
+		char acExpected [4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1];
+		const size_t expectedLen = addrComp.normalizeDeliveryLine( batchLines[nLine], acExpected, sizeof( acExpected));
+		if( (expectedLen != batchLengths[nLine]) || (0x0 != strcmp( acExpected, batchOutput.data() + nLine * BATCH_LINE_SIZE))) {
+			printf( "FAILURE for batch normalize ===== %s =====\n", batchLines[nLine]);
+			++ nBatchNormalizeFailed;
+		}
+	}
+	if( 0 != nBatchNormalizeFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// Generated corpora repeat for a seed and every line takes the path it was built for
+	int nCorpusFailed = 0;
+	libAddr::S_CORPUS_OPTIONS corpusOptions;
+	libAddr::corpusGenerator::defaultOptions( corpusOptions);
+	corpusOptions.punctuationPercent = 20;
+	corpusOptions.maxLength = 96;
+	libAddr::corpusGenerator firstCorpus( corpusOptions);
+	libAddr::corpusGenerator sameCorpus( corpusOptions);
+	corpusOptions.seed = 2;
+	libAddr::corpusGenerator otherCorpus( corpusOptions);
+	int nSameAsOther = 0;
+	for( int nLine = 0; 5000 > nLine; ++ nLine) {
+		char acFirst [MAX_CORPUS_LINE_SIZE + 1];
+		char acSame [MAX_CORPUS_LINE_SIZE + 1];
+		char acOther [MAX_CORPUS_LINE_SIZE + 1];
+		firstCorpus.nextLine( acFirst, sizeof( acFirst));
+		sameCorpus.nextLine( acSame, sizeof( acSame));
+		otherCorpus.nextLine( acOther, sizeof( acOther));
+		if( 0x0 != strcmp( acFirst, acSame)) ++ nCorpusFailed;
+		if( 0x0 == strcmp( acFirst, acOther)) ++ nSameAsOther;
+		const libAddr::deliveryLine &dl = parser.parse( acFirst, strlen( acFirst));
+		bool bThisPassed = true;
+		switch( firstCorpus.getLastPath()) {
+			case libAddr::CP_PO_BOX: bThisPassed = (0x0 != dl.getPOBox()[0]); break;
+			case libAddr::CP_RURAL_ROUTE: bThisPassed = (0x0 != dl.getRuralRoute()[0]); break;
+			case libAddr::CP_HIGHWAY: bThisPassed = (0x0 != strstr( dl.getStreetName(), "HWY")); break;
+			case libAddr::CP_STREET: bThisPassed = (0x0 != dl.getStreetType()[0]) && (0x0 == dl.getUnitType()[0]); break;
+			default: bThisPassed = (0x0 != dl.getStreetType()[0]) && (0x0 != dl.getUnitType()[0]); break;
+		}
+		if( ! bThisPassed) {
+			printf( "FAILURE for generated line ===== %s =====\n", acFirst);
+			++ nCorpusFailed;
+		}
+	}
+	if( 100 < nSameAsOther) ++ nCorpusFailed;
+	if( 0 != nCorpusFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// A compiled copy of the built in tables parses as they do, and a custom entry is used
+	int nDictionaryFailed = 0;
+	char acDictionaryFile [] = "/tmp/libAddr_UnitTest_XXXXXX";
+	const int fdDictionary = mkstemp( acDictionaryFile);
+	FILE *fBuiltIn = tmpfile();
+	libAddr::addressDictionary dictionary;
+	if( (0 > fdDictionary) || ((FILE *) 0x0 == fBuiltIn) || ! libAddr::addressDictionary::writeBuiltIn( fBuiltIn)) {
+		printf( "FAILURE writing the built in dictionary\n");
+		++ nDictionaryFailed;
+	}
+	else {
+		rewind( fBuiltIn);
+		if( ! dictionary.compile( fBuiltIn, acDictionaryFile) || ! dictionary.open( acDictionaryFile)) {
+			printf( "FAILURE compiling the built in dictionary: %s\n", dictionary.getError());
+			++ nDictionaryFailed;
+		}
+	}
+	libAddr::deliveryLineParser dictionaryParser;
+	dictionaryParser.setDictionary( &dictionary);
+	for( int nEngine = 0; 2 > nEngine; ++ nEngine) {
+		dictionaryParser.setEngine( (0 == nEngine) ? libAddr::PE_RULES : libAddr::PE_STATE_MACHINE);
+		for( int nInput = 0; nPos > nInput; ++ nInput) {
+			if( ! matchesKnownOutput( dictionaryParser.parse( TEST_ADDR [nInput], strlen( TEST_ADDR [nInput])), TEST_OUTPUTS + nInput)) {
+				printf( "FAILURE for compiled dictionary ===== %s =====\n", TEST_ADDR [nInput]);
+				++ nDictionaryFailed;
+			}
+		}
+	}
+	const char CUSTOM_DICTIONARY [] = "# Custom\n[street_types]\nFooway, fwy\n[rural_route_headers]\nSTAR ROUTE, STAR RTE\n";
+	FILE *fCustom = fmemopen( (void *) CUSTOM_DICTIONARY, strlen( CUSTOM_DICTIONARY), "r");
+	if( ! dictionary.compile( fCustom, acDictionaryFile) || ! dictionary.open( acDictionaryFile)) {
+		printf( "FAILURE compiling a custom dictionary: %s\n", dictionary.getError());
+		++ nDictionaryFailed;
+	}
+	fclose( fCustom);
+	const libAddr::deliveryLine &customLine = dictionaryParser.parse( "123 Main Fooway", 15);
+	if( (0x0 != strcmp( "FWY", customLine.getStreetType())) || (0x0 != strcmp( "MAIN", customLine.getStreetName()))) {
+		printf( "FAILURE for custom street type ===== %s =====\n", customLine.getStreetType());
+		++ nDictionaryFailed;
+	}
+	const libAddr::deliveryLine &routeLine = dictionaryParser.parse( "Star Route 4 Box 12", 19);
+	if( 0x0 != strcmp( "STAR RTE 4 BOX 12", routeLine.getRuralRoute())) {
+		printf( "FAILURE for custom route header ===== %s =====\n", routeLine.getRuralRoute());
+		++ nDictionaryFailed;
+	}
+	const char REPEATED_DICTIONARY [] = "[unit_types]\nAPT\napt, APT\n";
+	fCustom = fmemopen( (void *) REPEATED_DICTIONARY, strlen( REPEATED_DICTIONARY), "r");
+	if( dictionary.compile( fCustom, acDictionaryFile)) {
+		printf( "FAILURE a repeated key was compiled\n");
+		++ nDictionaryFailed;
+	}
+	fclose( fCustom);
+	FILE *fDamaged = fopen( acDictionaryFile, "wb");
+	if( (FILE *) 0x0 != fDamaged) {
+		char acDamaged [4096];
+		memset( acDamaged, 0xFF, sizeof( acDamaged));
+		memcpy( acDamaged, "LIBADDR", 8);
+		fwrite( acDamaged, 1, sizeof( acDamaged), fDamaged);
+		fclose( fDamaged);
+		if( dictionary.open( acDictionaryFile)) {
+			printf( "FAILURE a damaged dictionary was opened\n");
+			++ nDictionaryFailed;
+		}
+	}
+	if( 0 <= fdDictionary) {
+		close( fdDictionary);
+		unlink( acDictionaryFile);
+	}
+	if( (FILE *) 0x0 != fBuiltIn) fclose( fBuiltIn);
+	if( 0 != nDictionaryFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// Dictionaries reload under parsing threads, and replaced versions are freed
+	int nReloadFailed = 0;
+	char acFirstFile [] = "/tmp/libAddr_UnitTest_XXXXXX";
+	char acSecondFile [] = "/tmp/libAddr_UnitTest_XXXXXX";
+	const int fdFirst = mkstemp( acFirstFile);
+	const int fdSecond = mkstemp( acSecondFile);
+	libAddr::addressDictionary reloadCompiler;
+	for( int nFile = 0; 2 > nFile; ++ nFile) {
+		FILE *fSource = tmpfile();
+		if( ((FILE *) 0x0 == fSource) || ! libAddr::addressDictionary::writeBuiltIn( fSource)) {
+			++ nReloadFailed;
+			continue;
+		}
+		if( 1 == nFile) fputs( "[street_types]\nFOOWAY, FWY\n", fSource);
+		rewind( fSource);
+		if( ! reloadCompiler.compile( fSource, (0 == nFile) ? acFirstFile : acSecondFile)) {
+			printf( "FAILURE compiling a reload dictionary: %s\n", reloadCompiler.getError());
+			++ nReloadFailed;
+		}
+		fclose( fSource);
+	}
+	if( (0 > fdFirst) || (0 > fdSecond)) ++ nReloadFailed;
+	if( 0 == nReloadFailed) {
+		libAddr::dictionaryHandle handle;
+		nReloadFailed += runReloadStress( handle, acFirstFile, acSecondFile);
+		if( handle.reload( "/nonexistent/libAddr.dict") || (0x0 == handle.getError()[0]) || (200 != handle.getVersion())) {
+			printf( "FAILURE reloading a missing dictionary\n");
+			++ nReloadFailed;
+		}
+	}
+	if( 0 != nReloadFailed) printf( "FAILURE for dictionary reload: %d\n", nReloadFailed);
+	for( int nFile = 0; 2 > nFile; ++ nFile) {
+		const int fdFile = (0 == nFile) ? fdFirst : fdSecond;
+		if( 0 > fdFile) continue;
+		close( fdFile);
+		unlink( (0 == nFile) ? acFirstFile : acSecondFile);
+	}
+	if( 0 != nReloadFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// Results packed into an arena read back as parsed, in far less memory than full results
+	int nArenaFailed = 0;
+	libAddr::deliveryLineArena arena( 4096);
+	for( int nInput = 0; nPos > nInput; ++ nInput) {
+		if( ! arena.append( parser, TEST_ADDR [nInput], strlen( TEST_ADDR [nInput]))) ++ nArenaFailed;
+	}
+	libAddr::S_CORPUS_OPTIONS arenaOptions;
+	libAddr::corpusGenerator::defaultOptions( arenaOptions);
+	arenaOptions.maxLength = 96;
+	libAddr::corpusGenerator arenaGenerator( arenaOptions);
+	std::vector< std::string> arenaLines;
+	for( int nLine = 0; 20000 > nLine; ++ nLine) {
+		char acLine [MAX_CORPUS_LINE_SIZE + 1];
+		const size_t lineLen = arenaGenerator.nextLine( acLine, sizeof( acLine));
+		arenaLines.push_back( std::string( acLine, lineLen));
+		if( ! arena.append( parser, acLine, lineLen)) ++ nArenaFailed;
+	}
+	if( (size_t) (nPos + 20000) != arena.size()) ++ nArenaFailed;
+	for( size_t nRecord = 0; arena.size() > nRecord; ++ nRecord) {
+		libAddr::deliveryLineView arenaView;
+		const bool bKnown = ((size_t) nPos > nRecord);
+		const libAddr::deliveryLine &dl = bKnown ? parser.parse( TEST_ADDR [nRecord], strlen( TEST_ADDR [nRecord])) : parser.parse( arenaLines[nRecord - nPos].c_str(), arenaLines[nRecord - nPos].size());
+		const S_KNOWN_OUTPUT parsedOutput = {
+			dl.getStreetNumber(), dl.getPreDirectional(), dl.getStreetName(), dl.getStreetType(), dl.getPostDirectional(),
+			dl.getUnitType(), dl.getUnitNumber(), dl.getPOBox(), dl.getRuralRoute(), dl.getRemainder()
+		};
+		if( ! arena.get( nRecord, arenaView) || ! matchesKnownOutput( arenaView, &parsedOutput) || (bKnown && ! matchesKnownOutput( arenaView, TEST_OUTPUTS + nRecord))) {
+			printf( "FAILURE for arena record %zu\n", nRecord);
+			++ nArenaFailed;
+		}
+		if( 0x0 != strcmp( dl.getRemainder(), arena.getComponent( nRecord, libAddr::LC_REMAINDER))) ++ nArenaFailed;
+	}
+	libAddr::deliveryLineView arenaView;
+	if( arena.get( arena.size(), arenaView) || (0x0 != arena.getComponent( arena.size(), libAddr::LC_STREET_NAME)[0])) ++ nArenaFailed;
+	// Held against the parsed values alone, as a deliveryLine was before it kept the full line
+	const size_t valueBytes = 9 * (MAX_DELIVERY_LINE_ELEMENT_SIZE + 1) + (4 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 1);
+	if( (arena.size() * valueBytes) < (10 * arena.getBytesUsed())) {
+		printf( "FAILURE arena uses %zu bytes for %zu records\n", arena.getBytesUsed(), arena.size());
+		++ nArenaFailed;
+	}
+	arena.clear();
+	if( (0 != arena.size()) || ! arena.append( parser.parse( "", 0)) || ! arena.get( 0, arenaView) || (0x0 != arenaView.getRemainder()[0])) ++ nArenaFailed;
+	if( 0 != nArenaFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// Columnar batches hold the same values as row results, in valid Arrow layout, with enums encoded
+	int nColumnsFailed = 0;
+	libAddr::deliveryLineColumns columns;
+	if( (size_t) nPos != parser.parseBatch( TEST_ADDR, nPos, columns)) ++ nColumnsFailed;
+	std::string columnBuffer;
+	std::vector< size_t> columnOffsets( 1, 0);
+	for( const std::string &line : arenaLines) {
+		columnBuffer += line;
+		columnBuffer += '\n';
+		columnOffsets.push_back( columnBuffer.size());
+	}
+	if( arenaLines.size() != parser.parseBatch( columnBuffer.c_str(), columnOffsets.data(), arenaLines.size(), columns)) ++ nColumnsFailed;
+	if( (nPos + arenaLines.size()) != columns.size()) ++ nColumnsFailed;
+	for( int nComp = 0; libAddr::LC_COUNT > nComp; ++ nComp) {
+		const libAddr::E_LINE_COMPONENT component = (libAddr::E_LINE_COMPONENT) nComp;
+		const libAddr::S_STRING_COLUMN strings = columns.getStrings( component);
+		bool bValid = (0 == strings.offsets[0]);
+		for( size_t nValue = 0; bValid && (strings.nValues > nValue); ++ nValue) bValid = (strings.offsets[nValue] <= strings.offsets[nValue + 1]);
+		if( columns.isDictionaryEncoded( component)) {
+			const int32_t *indices = columns.getIndices( component);
+			bValid &= (0 == strings.offsets[1]) && (1024 > strings.nValues);
+			for( size_t nRow = 0; bValid && (columns.size() > nRow); ++ nRow) bValid = (0 <= indices[nRow]) && (strings.nValues > (size_t) indices[nRow]);
+		}
+		else {
+			bValid &= ((const int32_t *) 0x0 == columns.getIndices( component)) && (columns.size() == strings.nValues);
+		}
+		if( ! bValid) {
+			printf( "FAILURE for column layout %d\n", nComp);
+			++ nColumnsFailed;
+		}
+	}
+	for( size_t nRow = 0; columns.size() > nRow; ++ nRow) {
+		const bool bKnown = ((size_t) nPos > nRow);
+		const libAddr::deliveryLine &dl = bKnown ? parser.parse( TEST_ADDR [nRow], strlen( TEST_ADDR [nRow])) : parser.parse( arenaLines[nRow - nPos].c_str(), arenaLines[nRow - nPos].size());
+		const char *allExpected [libAddr::LC_COUNT] = {
+			dl.getStreetNumber(), dl.getPreDirectional(), dl.getStreetName(), dl.getStreetType(), dl.getPostDirectional(),
+			dl.getUnitType(), dl.getUnitNumber(), dl.getPOBox(), dl.getRuralRoute(), dl.getRemainder()
+		};
+		for( int nComp = 0; libAddr::LC_COUNT > nComp; ++ nComp) {
+			const char *pValue;
+			const size_t valueLen = columns.getValue( nRow, (libAddr::E_LINE_COMPONENT) nComp, pValue);
+			if( (strlen( allExpected[nComp]) != valueLen) || (0x0 != strncmp( allExpected[nComp], pValue, valueLen))) {
+				printf( "FAILURE for column %d row %zu\n", nComp, nRow);
+				++ nColumnsFailed;
+			}
+		}
+	}
+	columns.clear();
+	const char *pClearedValue = (const char *) 0x0;
+	if( (0 != columns.size()) || (0 != columns.getValue( 0, libAddr::LC_STREET_NAME, pClearedValue)) || (0x0 != pClearedValue[0])) ++ nColumnsFailed;
+	if( 0 != nColumnsFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// Full lines - built on request, and rebuilt after every parse and cache hit
+	int nFullLineFailed = 0;
+	libAddr::deliveryLineCache fullLineCache( 1 << 20);
+	for( int nPass = 0; 3 > nPass; ++ nPass) {
+		for( int nKnown = 0; nPos > nKnown; ++ nKnown) {
+			const S_KNOWN_OUTPUT &known = TEST_OUTPUTS [nKnown];
+			const char *allKnown [libAddr::LC_COUNT] = {
+				known.pStreetNumber, known.pPreDirectional, known.pStreetName, known.pStreetType, known.pPostDirectional,
+				known.pUnitType, known.pUnitNumber, known.pPOBox, known.pRuralRoute, known.pRemainder
+			};
+			std::string expectFull;
+			std::string expectNoNumber;
+			for( int nComp = 0; libAddr::LC_COUNT > nComp; ++ nComp) {
+				if( 0x0 == allKnown[nComp][0]) continue;
+				if( ! expectFull.empty()) expectFull += " ";
+				expectFull += allKnown[nComp];
+				if( libAddr::LC_STREET_NUMBER == nComp) continue;
+				if( ! expectNoNumber.empty()) expectNoNumber += " ";
+				expectNoNumber += allKnown[nComp];
+			}
+			if( 0x0 == known.pStreetName[0]) expectNoNumber.clear();
+			const libAddr::deliveryLine &dl = (0 == nPass) ? parser.parse( TEST_ADDR [nKnown], strlen( TEST_ADDR [nKnown])) :
+				fullLineCache.parse( parser, TEST_ADDR [nKnown], strlen( TEST_ADDR [nKnown]));
+			if( (expectFull != dl.getFullLine()) || (expectNoNumber != dl.getFullLineNoNumber()) || (expectFull != dl.getFullLine())) {
+				printf( "FAILURE for full line %d: ~%s~ ~%s~\n", nKnown, dl.getFullLine(), dl.getFullLineNoNumber());
+				++ nFullLineFailed;
+			}
+		}
+	}
+	libAddr::deliveryLine emptyLine;
+	if( (0x0 != emptyLine.getFullLine()[0]) || (0x0 != emptyLine.getFullLineNoNumber()[0])) ++ nFullLineFailed;
+	if( 0 != nFullLineFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// Fuzzy types - misspellings corrected only when asked, and real words left alone
+	int nFuzzyFailed = 0;
+	const char * FUZZY_INPUTS [][5] = {
+		// Input						Street type		Unit type		Unit number		Remainder when exact
+		{ "123 MAIN BOULVARD",			"BLVD",			"",				"",				"123 MAIN BOULVARD" },
+		{ "55 OAK AVNEUE",				"AVE",			"",				"",				"55 OAK AVNEUE" },
+		{ "7 ELM STRET APRT 4",			"ST",			"APT",			"4",			"7 ELM STRET APRT 4" },
+		{ "100 FIRST STREET APRT 9",	"ST",			"APT",			"9",			(const char *) 0x0 },
+		{ "44 MARTIN LUTHER KING",		"",				"",				"",				"44 MARTIN LUTHER KING" },
+		{ "25 LOT SOUND NE STATE",		"",				"",				"",				"25 LOT SOUND NE STATE" },
+		{ (const char *) 0x0, 0x0, 0x0, 0x0, 0x0 }
+	};
+	libAddr::deliveryLineParser fuzzyParser;
+	for( int nEngine = 0; 2 > nEngine; ++ nEngine) {
+		fuzzyParser.setEngine( (0 == nEngine) ? libAddr::PE_RULES : libAddr::PE_STATE_MACHINE);
+		for( int nFuzzy = 0; (const char *) 0x0 != FUZZY_INPUTS[nFuzzy][0]; ++ nFuzzy) {
+			const char **allFuzzy = FUZZY_INPUTS[nFuzzy];
+			fuzzyParser.setFuzzyDistance( 0);
+			const libAddr::deliveryLine &dlExact = fuzzyParser.parse( allFuzzy[0], strlen( allFuzzy[0]));
+			if( ((const char *) 0x0 != allFuzzy[4]) && (0x0 != strcmp( allFuzzy[4], dlExact.getRemainder()))) ++ nFuzzyFailed;
+			fuzzyParser.setFuzzyDistance( MAX_FUZZY_DISTANCE);
+			const libAddr::deliveryLine &dl = fuzzyParser.parse( allFuzzy[0], strlen( allFuzzy[0]));
+			if( (0x0 != strcmp( allFuzzy[1], dl.getStreetType())) || (0x0 != strcmp( allFuzzy[2], dl.getUnitType())) || (0x0 != strcmp( allFuzzy[3], dl.getUnitNumber()))) {
+				printf( "FAILURE for fuzzy input %s\n", allFuzzy[0]);
+				++ nFuzzyFailed;
+			}
+		}
+	}
+	for( int nKnown = 0; nPos > nKnown; ++ nKnown) {
+		if( ! matchesKnownOutput( fuzzyParser.parse( TEST_ADDR [nKnown], strlen( TEST_ADDR [nKnown])), TEST_OUTPUTS + nKnown)) ++ nFuzzyFailed;
+	}
+	libAddr::deliveryLineCache fuzzyCache( 1 << 20);
+	for( int nRepeat = 0; 2 > nRepeat; ++ nRepeat) {
+		char acFuzzyLine [64] = "123 Main Stret Aprt 4";
+		const char *pFuzzyLine = acFuzzyLine;
+		char acFuzzyBatch [64];
+		fuzzyCache.normalizeDeliveryLine( fuzzyParser, acFuzzyLine, sizeof( acFuzzyLine));
+		fuzzyParser.normalizeBatch( &pFuzzyLine, 1, acFuzzyBatch, sizeof( acFuzzyBatch), (size_t *) 0x0);
+		if( (0x0 != strcmp( "123 MAIN ST APT 4", acFuzzyLine)) || (0x0 != strcmp( acFuzzyLine, acFuzzyBatch))) {
+			printf( "FAILURE for fuzzy cached normalize: ~%s~\n", acFuzzyLine);
+			++ nFuzzyFailed;
+		}
+	}
+	libAddr::addressCompression fuzzyComp;
+	if( (const libAddr::S_CONVERSION_TYPE *) 0x0 != fuzzyComp.lookupStreetTypeFuzzy( "STRET", 5, 0)) ++ nFuzzyFailed;
+	if( (const libAddr::S_CONVERSION_TYPE *) 0x0 != fuzzyComp.lookupStreetTypeFuzzy( "SR", 2, MAX_FUZZY_DISTANCE)) ++ nFuzzyFailed;
+	if( (const libAddr::S_CONVERSION_TYPE *) 0x0 != fuzzyComp.lookupStreetTypeFuzzy( "STR3ET", 6, MAX_FUZZY_DISTANCE)) ++ nFuzzyFailed;
+	if( (const libAddr::S_CONVERSION_TYPE *) 0x0 != fuzzyComp.lookupStreetTypeFuzzy( "BULEVRAD", 8, 1)) ++ nFuzzyFailed;
+	const libAddr::S_CONVERSION_TYPE *ctFuzzy = fuzzyComp.lookupStreetTypeFuzzy( "BULEVRAD", 8, MAX_FUZZY_DISTANCE);
+	if( ((const libAddr::S_CONVERSION_TYPE *) 0x0 == ctFuzzy) || (0x0 != strcmp( "BLVD", ctFuzzy->preftype))) ++ nFuzzyFailed;
+	if( 0 != nFuzzyFailed) {
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
+	// Parse statistics - counted when built in, all zero when not
+	libAddr::deliveryLine::resetStatistics();
+	int nStatisticsFailed = 0;
+	uint64_t nExpectedPOBox = 0;
+	uint64_t nExpectedRuralRoute = 0;
+	for( int nKnown = 0; nPos > nKnown; ++ nKnown) {
+		parser.parse( TEST_ADDR [nKnown], strlen( TEST_ADDR [nKnown]));
+		if( 0x0 != TEST_OUTPUTS [nKnown].pPOBox[0]) ++ nExpectedPOBox;
+		if( 0x0 != TEST_OUTPUTS [nKnown].pRuralRoute[0]) ++ nExpectedRuralRoute;
+	}
+	libAddr::S_PARSE_STATISTICS statistics;
+	libAddr::deliveryLine::getStatistics( statistics);
+	if( libAddr::deliveryLine::isInstrumented()) {
+		if( (uint64_t) nPos != statistics.lines) ++ nStatisticsFailed;
+		if( nExpectedPOBox != statistics.branches[libAddr::PB_PO_BOX]) ++ nStatisticsFailed;
+		if( nExpectedRuralRoute != statistics.branches[libAddr::PB_RURAL_ROUTE]) ++ nStatisticsFailed;
+		if( statistics.lines < statistics.stageCalls[libAddr::PS_PREPASS]) ++ nStatisticsFailed;
+		if( statistics.lines != (statistics.branches[libAddr::PB_PO_BOX] + statistics.branches[libAddr::PB_RURAL_ROUTE] +
+			statistics.branches[libAddr::PB_STREET_TYPE] + statistics.branches[libAddr::PB_REMAINDER])) ++ nStatisticsFailed;
+		libAddr::deliveryLine::resetStatistics();
+		libAddr::deliveryLine::getStatistics( statistics);
+	}
+	if( 0 != statistics.lines) ++ nStatisticsFailed;
+	for( int nBranch = 0; libAddr::PB_COUNT > nBranch; ++ nBranch) if( 0 != statistics.branches[nBranch]) ++ nStatisticsFailed;
+	if( 0 != nStatisticsFailed) {
+		printf( "FAILURE for parse statistics\n");
+		bAllPassed = false;
+		++ nFailed;
+	}
+	else {
+		++ nPassed;
+	}
+
 	// If everything passed ...
 	if( bAllPassed)
 		printf( "All %d unit tests passed\n", nPassed);
@@ -0,0 +1,129 @@
+//
+//  addrdict.cpp
+//  libAddr
+//
+//  This program compiles a text dictionary source into the
+//  file the parser maps, writes the built in tables as a
+//  source to start from, and describes a compiled file.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+// Project includes
+#include <libAddr.hpp>
+#include <libAddrDictionary.hpp>
+
+// Table names, as written with -i
+const char * TABLE_NAMES [] = { "street types", "unit types", "other conversions", "directionals", "PO box headers", "rural route headers", 0x0 };
+
+//
+// Usage
+//
+void usage( const char *pProgram) {
+	fprintf( stderr, "Usage: %s source_file output_file\n", pProgram);
+	fprintf( stderr, "       %s -x\n", pProgram);
+	fprintf( stderr, "       %s -i dictionary_file\n", pProgram);
+	fprintf( stderr, "  source_file  text source to compile, - for standard input\n");
+	fprintf( stderr, "  -x           write the built in tables as a source\n");
+	fprintf( stderr, "  -i file      describe a compiled dictionary\n");
+}
+
+//////////
+// MAIN //
+//////////
+
+int main( int argc, char **argv) {
+
+	// Options
+	const char *pDescribeFile = (const char *) 0x0;
+	bool bWriteBuiltIn = false;
+	int nOpt;
+	while( -1 != (nOpt = getopt( argc, argv, "xi:"))) {
+		switch( nOpt) {
+			case 'x': bWriteBuiltIn = true; break;
+			case 'i': pDescribeFile = optarg; break;
+			default: usage( argv[0]); return( EXIT_FAILURE);
+		}
+	}
+
+	// Write the built in tables
+	if( bWriteBuiltIn) {
+		if( (optind != argc) || ((const char *) 0x0 != pDescribeFile)) {
+			usage( argv[0]);
+			return( EXIT_FAILURE);
+		}
+		if( ! libAddr::addressDictionary::writeBuiltIn( stdout) || (0 != fflush( stdout))) {
+			perror( "Unable to write the output");
+			return( EXIT_FAILURE);
+		}
+		return( EXIT_SUCCESS);
+	}
+
+	// Describe a compiled file
+	libAddr::addressDictionary dictionary;
+	if( (const char *) 0x0 != pDescribeFile) {
+		if( optind != argc) {
+			usage( argv[0]);
+			return( EXIT_FAILURE);
+		}
+		if( ! dictionary.open( pDescribeFile)) {
+			fprintf( stderr, "%s\n", dictionary.getError());
+			return( EXIT_FAILURE);
+		}
+		for( int nTable = 0; libAddr::DT_COUNT > nTable; ++ nTable) {
+			printf( "%-20s %zu\n", TABLE_NAMES[nTable], dictionary.getCount( (libAddr::E_DICTIONARY_TABLE) nTable));
+		}
+		return( EXIT_SUCCESS);
+	}
+
+	// Compile a source
+	if( (optind + 2) != argc) {
+		usage( argv[0]);
+		return( EXIT_FAILURE);
+	}
+	FILE *fSource = (0x0 == strcmp( "-", argv[optind])) ? stdin : fopen( argv[optind], "r");
+	if( (FILE *) 0x0 == fSource) {
+		fprintf( stderr, "Unable to open %s: %s\n", argv[optind], strerror( errno));
+		return( EXIT_FAILURE);
+	}
+	const bool bCompiled = dictionary.compile( fSource, argv[optind + 1]);
+	if( stdin != fSource) fclose( fSource);
+	if( ! bCompiled) {
+		fprintf( stderr, "%s: %s\n", argv[optind], dictionary.getError());
+		return( EXIT_FAILURE);
+	}
+	return( EXIT_SUCCESS);
+
+}
@@ -0,0 +1,135 @@
+//
+//  addrgen.cpp
+//  libAddr
+//
+//  This program writes a synthetic corpus of delivery lines,
+//  one per line, for load and regression testing.  The same
+//  options always give the same output.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+// Project includes
+#include <libAddr.hpp>
+#include <libAddrCorpus.hpp>
+
+// Path names, as written with -P
+const char * CORPUS_PATH_NAMES [] = { "street", "unit_after", "unit_before", "hash_unit", "po_box", "rural_route", "highway", 0x0 };
+
+//
+// Read a comma separated list of weights; returns false if it is malformed
+//
+bool parseWeights( const char *pList, uint32_t *weights, const int nWeights) {
+	for( int nPos = 0; nWeights > nPos; ++ nPos) {
+		char *pEnd = (char *) 0x0;
+		long nValue = strtol( pList, &pEnd, 10);
+		if( (pEnd == pList) || (0 > nValue)) return( false);
+		weights[nPos] = (uint32_t) nValue;
+		if( (nWeights - 1) == nPos) return( 0x0 == *pEnd);
+		if( ',' != *pEnd) return( false);
+		pList = pEnd + 1;
+	}
+	return( true);
+}
+
+//
+// Usage
+//
+void usage( const char *pProgram) {
+	fprintf( stderr, "Usage: %s [-s seed] [-n lines] [-w path weights] [-c casing weights] [-l min,max] [-x percent] [-P]\n", pProgram);
+	fprintf( stderr, "  -s seed     random seed (default 1)\n");
+	fprintf( stderr, "  -n lines    lines to write (default 1000000)\n");
+	fprintf( stderr, "  -w weights  street,unit after,unit before,# unit,po box,rural route,highway (default 40,15,5,10,15,10,5)\n");
+	fprintf( stderr, "  -c weights  upper,lower,title,mixed casing (default 40,10,40,10)\n");
+	fprintf( stderr, "  -l min,max  line length range to pad toward (default 16,40)\n");
+	fprintf( stderr, "  -x percent  chance per word of stray punctuation (default 5)\n");
+	fprintf( stderr, "  -P          write the path name and a tab before each line\n");
+}
+
+//////////
+// MAIN //
+//////////
+
+int main( int argc, char **argv) {
+
+	// Options
+	libAddr::S_CORPUS_OPTIONS options;
+	libAddr::corpusGenerator::defaultOptions( options);
+	unsigned long long nLines = 1000000;
+	bool bWritePath = false;
+	bool bBadOption = false;
+	uint32_t lengths [2];
+	int nOpt;
+	while( -1 != (nOpt = getopt( argc, argv, "s:n:w:c:l:x:P"))) {
+		switch( nOpt) {
+			case 's': options.seed = strtoull( optarg, (char **) 0x0, 0); break;
+			case 'n': nLines = strtoull( optarg, (char **) 0x0, 10); break;
+			case 'w': bBadOption |= ! parseWeights( optarg, options.pathWeight, libAddr::CP_COUNT); break;
+			case 'c': bBadOption |= ! parseWeights( optarg, options.casingWeight, libAddr::CC_COUNT); break;
+			case 'l':
+				bBadOption |= ! parseWeights( optarg, lengths, 2);
+				options.minLength = lengths[0];
+				options.maxLength = lengths[1];
+				break;
+			case 'x': options.punctuationPercent = (uint32_t) atoi( optarg); break;
+			case 'P': bWritePath = true; break;
+			default: bBadOption = true; break;
+		}
+	}
+	if( bBadOption || (optind != argc)) {
+		usage( argv[0]);
+		return( EXIT_FAILURE);
+	}
+
+	// Write the lines
+	static char acOutput [1 << 20];
+	setvbuf( stdout, acOutput, _IOFBF, sizeof( acOutput));
+	libAddr::corpusGenerator generator( options);
+	char acLine [MAX_CORPUS_LINE_SIZE + 1];
+	for( unsigned long long nLine = 0; nLines > nLine; ++ nLine) {
+		size_t lineLen = generator.nextLine( acLine, sizeof( acLine));
+		if( bWritePath) {
+			fputs( CORPUS_PATH_NAMES[generator.getLastPath()], stdout);
+			putchar( '\t');
+		}
+		acLine[lineLen] = '\n';
+		fwrite( acLine, 1, lineLen + 1, stdout);
+	}
+	if( 0 != fflush( stdout)) {
+		perror( "Unable to write the output");
+		return( EXIT_FAILURE);
+	}
+	return( EXIT_SUCCESS);
+
+}
@@ -0,0 +1,541 @@
+//
+//  addrparse.cpp
+//  libAddr
+//
+//  This program parses every delivery line in a file and writes
+//  the components back out as delimited text.  The input is
+//  memory mapped and the output is written in large blocks.
+//
+//  With more than one thread the file is cut into newline aligned
+//  chunks that a pool of workers parses; the chunk outputs are
+//  written back in input order so the result matches a single
+//  threaded run byte for byte.
+//
+//  Copyright © 2019 Louis Gehrig. All rights reserved.
+//
+
+/***
+
+	MIT License
+
+	Copyright (c) 2019 Louis Gehrig
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+
+***/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <memory.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// STL includes
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Project includes
+#include <libAddr.hpp>
+#include <libAddrCache.hpp>
+#include <libAddrDictionary.hpp>
+
+// Output block size
+const size_t OUTPUT_BUFFER_SIZE = 1 << 20;
+
+// Input chunk size for the threaded mode
+const size_t INPUT_CHUNK_SIZE = 1 << 20;
+
+// Chunks per worker that may be parsed ahead of the writer
+const size_t REORDER_CHUNKS_PER_WORKER = 4;
+
+// Largest single output record - ten components, delimiters and the echoed input
+const size_t MAX_OUTPUT_RECORD = 16 * MAX_DELIVERY_LINE_ELEMENT_SIZE + 16;
+
+// The run options
+struct s_run_options {
+	const char *pInputFile;			// File to parse
+	int nColumn;					// 1-based column to parse, 0 for the whole line
+	char cInputDelim;				// Input column delimiter
+	char cOutputDelim;				// Output component delimiter
+	bool bSkipHeader;				// Skip the first line
+	bool bEchoInput;				// Write the input value before the components
+	int nThreads;					// Worker threads
+	size_t cacheBytes;				// Parse cache size, 0 for none
+	libAddr::deliveryLineCache *pCache;
+	libAddr::E_PARSE_ENGINE engine;	// Parse engine
+	libAddr::addressDictionary *pDictionary;	// Compiled dictionary, null for the built in tables
+	int nFuzzyDistance;				// Misspelled types corrected within this, 0 for none
+};
+typedef struct s_run_options S_RUN_OPTIONS;
+
+// A blocked writer to a file descriptor - or, with no descriptor, a growing memory buffer
+struct s_output_buffer {
+	int fdOutput;
+	size_t nUsed;
+	size_t nSize;
+	bool bFailed;
+	char *pBuffer;
+};
+typedef struct s_output_buffer S_OUTPUT_BUFFER;
+
+//
+// Write out everything buffered
+//
+void flushOutput( S_OUTPUT_BUFFER &output) {
+
+	size_t nWritten = 0;
+	while( (! output.bFailed) && (output.nUsed > nWritten)) {
+		ssize_t nBytes = write( output.fdOutput, output.pBuffer + nWritten, output.nUsed - nWritten);
+		if( 0 <= nBytes) nWritten += (size_t) nBytes;
+		else if( EINTR != errno) output.bFailed = true;
+	}
+	output.nUsed = 0;
+
+}
+
+//
+// Make room for one more record
+//
+void reserveOutput( S_OUTPUT_BUFFER &output) {
+
+	if( MAX_OUTPUT_RECORD <= (output.nSize - output.nUsed)) return;
+
+	// Write it out
+	if( 0 <= output.fdOutput) {
+		flushOutput( output);
+		return;
+	}
+
+	// Or grow it
+	size_t nNewSize = output.nSize * 2;
+	if( MAX_OUTPUT_RECORD > nNewSize) nNewSize = OUTPUT_BUFFER_SIZE;
+	char *pNewBuffer = (char *) realloc( output.pBuffer, nNewSize);
+	if( (char *) 0x0 == pNewBuffer) {
+		output.bFailed = true;
+		output.nUsed = 0;
+		return;
+	}
+	output.pBuffer = pNewBuffer;
+	output.nSize = nNewSize;
+
+}
+
+//
+// Append bytes to the output
+//
+inline void appendOutput( S_OUTPUT_BUFFER &output, const char *pValue, const size_t valueLen) {
+	memcpy( output.pBuffer + output.nUsed, pValue, valueLen);
+	output.nUsed += valueLen;
+}
+
+//
+// Find the wanted column of a line - CSV style double quotes are honored
+// Returns the column start and sets its length; quotes are left for the parser to drop
+//
+const char * findColumn( const char *pLine, const size_t lineLen, const S_RUN_OPTIONS &options, size_t &columnLen) {
+
+	// Whole line?
+	if( 0 == options.nColumn) {
+		columnLen = lineLen;
+		return( pLine);
+	}
+
+	int nCurColumn = 1;
+	size_t nStart = 0;
+	bool bQuoted = false;
+	for( size_t nPos = 0; lineLen >= nPos; ++ nPos) {
+		if( (lineLen == nPos) || ((! bQuoted) && (options.cInputDelim == pLine[nPos]))) {
+			if( options.nColumn == nCurColumn) {
+				columnLen = nPos - nStart;
+				return( pLine + nStart);
+			}
+			++ nCurColumn;
+			nStart = nPos + 1;
+		}
+		else if( '"' == pLine[nPos]) {
+			bQuoted = ! bQuoted;
+		}
+	}
+
+	// Not that many columns
+	columnLen = 0;
+	return( pLine);
+
+}
+
+//
+// Write one parsed record
+//
+void writeRecord( S_OUTPUT_BUFFER &output, const S_RUN_OPTIONS &options, const char *pColumn, size_t columnLen, const libAddr::deliveryLine &dl) {
+
+	const char *allValues [] = {
+		dl.getStreetNumber(), dl.getPreDirectional(), dl.getStreetName(), dl.getStreetType(), dl.getPostDirectional(),
+		dl.getUnitType(), dl.getUnitNumber(), dl.getPOBox(), dl.getRuralRoute(), dl.getRemainder()
+	};
+
+	reserveOutput( output);
+	if( output.bFailed) return;
+
+	// The input, as given, when asked for
+	if( options.bEchoInput) {
+		if( (4 * MAX_DELIVERY_LINE_ELEMENT_SIZE) < columnLen) columnLen = 4 * MAX_DELIVERY_LINE_ELEMENT_SIZE;
+		appendOutput( output, pColumn, columnLen);
+		appendOutput( output, &options.cOutputDelim, 1);
+	}
+
+	// And every component
+	for( size_t nValue = 0; (sizeof( allValues) / sizeof( allValues[0])) > nValue; ++ nValue) {
+		if( 0 != nValue) appendOutput( output, &options.cOutputDelim, 1);
+		appendOutput( output, allValues[nValue], strlen( allValues[nValue]));
+	}
+	appendOutput( output, "\n", 1);
+
+}
+
+//
+// Parse and write every line from pStart up to pEnd
+//
+void parseRange( const char *pStart, const char *pEnd, const S_RUN_OPTIONS &options, libAddr::deliveryLineParser &parser, S_OUTPUT_BUFFER &output) {
+
+	while( (pEnd > pStart) && (! output.bFailed)) {
+
+		// Find the line
+		const char *pLine = pStart;
+		const char *pNewLine = (const char *) memchr( pLine, '\n', pEnd - pStart);
+		size_t lineLen = ((const char *) 0x0 == pNewLine) ? (size_t) (pEnd - pStart) : (size_t) (pNewLine - pLine);
+		pStart += lineLen + 1;
+		if( (0 < lineLen) && ('\r' == pLine[lineLen - 1])) -- lineLen;
+
+		// Parse and write
+		size_t columnLen = 0;
+		const char *pColumn = findColumn( pLine, lineLen, options, columnLen);
+		const libAddr::deliveryLine &dl = ((libAddr::deliveryLineCache *) 0x0 == options.pCache) ?
+			parser.parse( pColumn, columnLen) : options.pCache->parse( parser, pColumn, columnLen);
+		writeRecord( output, options, pColumn, columnLen, dl);
+
+	}
+
+}
+
+// One chunk of the input and its parsed output
+struct s_chunk {
+	const char *pStart;
+	const char *pEnd;
+	S_OUTPUT_BUFFER output;
+	bool bReady;
+};
+typedef struct s_chunk S_CHUNK;
+
+// A worker's queue of chunk numbers - taken lowest first by the owner and by thieves
+struct s_work_queue {
+	std::mutex queueLock;
+	std::vector< size_t> chunks;
+	size_t nNext;
+};
+typedef struct s_work_queue S_WORK_QUEUE;
+
+//
+// The threaded pipeline
+//
+// Chunks are dealt to the workers in stripes.  A worker takes its
+// own lowest chunk and, once its queue is empty, steals the lowest
+// chunk of another worker.  No chunk more than a window ahead of the
+// writer is taken, which bounds the memory held by the reorder buffer.
+//
+
+class parsePipeline {
+
+public:
+
+	parsePipeline( const S_RUN_OPTIONS &runOptions, const char *pStart, const char *pEnd, const int fdOutput) :
+		options( runOptions), fdOut( fdOutput), nWritten( 0), bFailed( false), allQueues( runOptions.nThreads) {
+
+		// Cut the input on line ends
+		while( pEnd > pStart) {
+			const char *pChunkEnd = pStart + INPUT_CHUNK_SIZE;
+			if( pEnd <= pChunkEnd) pChunkEnd = pEnd;
+			else {
+				const char *pNewLine = (const char *) memchr( pChunkEnd, '\n', pEnd - pChunkEnd);
+				pChunkEnd = ((const char *) 0x0 == pNewLine) ? pEnd : (pNewLine + 1);
+			}
+			S_CHUNK chunk = { pStart, pChunkEnd, { -1, 0, 0, false, (char *) 0x0 }, false };
+			allChunks.push_back( chunk);
+			pStart = pChunkEnd;
+		}
+
+		// Deal the chunks out in stripes
+		const size_t nWorkers = allQueues.size();
+		const size_t nStripe = 4;
+		for( size_t nChunk = 0; allChunks.size() > nChunk; ++ nChunk)
+			allQueues[(nChunk / nStripe) % nWorkers].chunks.push_back( nChunk);
+		for( size_t nWorker = 0; nWorkers > nWorker; ++ nWorker) allQueues[nWorker].nNext = 0;
+		nWindow = nWorkers * REORDER_CHUNKS_PER_WORKER;
+
+	}
+
+	// Run the workers and write the output; returns false on a failure
+	bool run( ) {
+
+		std::vector< std::thread> allWorkers;
+		for( size_t nWorker = 0; allQueues.size() > nWorker; ++ nWorker)
+			allWorkers.push_back( std::thread( &parsePipeline::work, this, nWorker));
+
+		// Write the chunks in order
+		for( size_t nChunk = 0; allChunks.size() > nChunk; ++ nChunk) {
+			S_CHUNK &chunk = allChunks[nChunk];
+			{
+				std::unique_lock< std::mutex> lock( stateLock);
+				chunkReady.wait( lock, [&chunk] { return( chunk.bReady); });
+			}
+			S_OUTPUT_BUFFER toWrite = chunk.output;
+			toWrite.fdOutput = fdOut;
+			if( chunk.output.bFailed) bFailed = true;
+			else if( ! bFailed) {
+				flushOutput( toWrite);
+				bFailed = toWrite.bFailed;
+			}
+			free( chunk.output.pBuffer);
+			chunk.output.pBuffer = (char *) 0x0;
+			{
+				std::lock_guard< std::mutex> lock( stateLock);
+				++ nWritten;
+				if( bFailed) nWritten = allChunks.size();
+			}
+			windowMoved.notify_all();
+			if( bFailed) break;
+		}
+
+		for( size_t nWorker = 0; allWorkers.size() > nWorker; ++ nWorker) allWorkers[nWorker].join();
+		for( size_t nChunk = 0; allChunks.size() > nChunk; ++ nChunk) free( allChunks[nChunk].output.pBuffer);
+		return( ! bFailed);
+
+	}
+
+protected:
+
+	// Take the lowest chunk from a queue, if it is inside the window
+	// Returns false if the queue is empty; sets nChunk to the chunk or to allChunks.size() if outside the window
+	bool takeChunk( S_WORK_QUEUE &queue, const size_t nLimit, size_t &nChunk) {
+		std::lock_guard< std::mutex> lock( queue.queueLock);
+		if( queue.chunks.size() <= queue.nNext) return( false);
+		nChunk = queue.chunks[queue.nNext];
+		if( nLimit <= nChunk) nChunk = allChunks.size();
+		else ++ queue.nNext;
+		return( true);
+	}
+
+	// Find the next chunk for a worker; returns allChunks.size() once all are taken
+	size_t nextChunk( const size_t nWorker) {
+
+		const size_t nWorkers = allQueues.size();
+		while( true) {
+
+			size_t nLimit;
+			{
+				std::lock_guard< std::mutex> lock( stateLock);
+				if( allChunks.size() <= nWritten) return( allChunks.size());
+				nLimit = nWritten + nWindow;
+			}
+
+			// Own queue, then steal
+			bool bAnyLeft = false;
+			for( size_t nOffset = 0; nWorkers > nOffset; ++ nOffset) {
+				size_t nChunk = 0;
+				if( ! takeChunk( allQueues[(nWorker + nOffset) % nWorkers], nLimit, nChunk)) continue;
+				if( allChunks.size() > nChunk) return( nChunk);
+				bAnyLeft = true;
+			}
+			if( ! bAnyLeft) return( allChunks.size());
+
+			// Everything left is too far ahead - wait for the writer
+			std::unique_lock< std::mutex> lock( stateLock);
+			windowMoved.wait( lock, [this, nLimit] { return( (nWritten + nWindow) > nLimit); });
+
+		}
+
+	}
+
+	// A worker thread
+	void work( const size_t nWorker) {
+
+		libAddr::deliveryLineParser parser;
+		parser.setEngine( options.engine);
+		parser.setDictionary( options.pDictionary);
+		parser.setFuzzyDistance( options.nFuzzyDistance);
+		size_t nChunk;
+		while( allChunks.size() > (nChunk = nextChunk( nWorker))) {
+			S_CHUNK &chunk = allChunks[nChunk];
+			parseRange( chunk.pStart, chunk.pEnd, options, parser, chunk.output);
+			{
+				std::lock_guard< std::mutex> lock( stateLock);
+				chunk.bReady = true;
+			}
+			chunkReady.notify_all();
+		}
+
+	}
+
+	const S_RUN_OPTIONS &options;
+	const int fdOut;
+	size_t nWindow;
+	size_t nWritten;
+	bool bFailed;
+	std::mutex stateLock;
+	std::condition_variable chunkReady;
+	std::condition_variable windowMoved;
+	std::vector< S_CHUNK> allChunks;
+	std::vector< S_WORK_QUEUE> allQueues;
+
+};
+
+//
+// Usage
+//
+void usage( const char *pProgram) {
+	fprintf( stderr, "Usage: %s [-c column] [-d input delimiter] [-o output delimiter] [-H] [-e] [-j threads] [-C megabytes] [-m] [-D dictionary] [-f distance] input_file\n", pProgram);
+	fprintf( stderr, "  -c column   1-based column holding the delivery line (default: the whole line)\n");
+	fprintf( stderr, "  -d char     input column delimiter (default ',')\n");
+	fprintf( stderr, "  -o char     output delimiter (default '|')\n");
+	fprintf( stderr, "  -H          skip the first (header) line\n");
+	fprintf( stderr, "  -e          echo the input value before the components\n");
+	fprintf( stderr, "  -j threads  worker threads, 0 for one per core (default 1)\n");
+	fprintf( stderr, "  -C mb       cache parse results for repeated lines in up to this many megabytes\n");
+	fprintf( stderr, "  -m          parse with the state machine engine\n");
+	fprintf( stderr, "  -D file     parse with a dictionary compiled by addrdict\n");
+	fprintf( stderr, "  -f distance correct misspelled street and unit types within this many edits (1 or 2)\n");
+}
+
+//////////
+// MAIN //
+//////////
+
+int main( int argc, char **argv) {
+
+	// Options
+	S_RUN_OPTIONS options = { (const char *) 0x0, 0, ',', '|', false, false, 1, 0, (libAddr::deliveryLineCache *) 0x0, libAddr::PE_RULES, (libAddr::addressDictionary *) 0x0, 0 };
+	libAddr::addressDictionary dictionary;
+	int nOpt;
+	while( -1 != (nOpt = getopt( argc, argv, "c:d:o:Hej:C:mD:f:"))) {
+		switch( nOpt) {
+			case 'c': options.nColumn = atoi( optarg); break;
+			case 'd': options.cInputDelim = ('t' == optarg[0] && 0x0 == optarg[1]) ? '\t' : optarg[0]; break;
+			case 'o': options.cOutputDelim = ('t' == optarg[0] && 0x0 == optarg[1]) ? '\t' : optarg[0]; break;
+			case 'H': options.bSkipHeader = true; break;
+			case 'e': options.bEchoInput = true; break;
+			case 'j': options.nThreads = atoi( optarg); break;
+			case 'C': options.cacheBytes = (size_t) atol( optarg) << 20; break;
+			case 'm': options.engine = libAddr::PE_STATE_MACHINE; break;
+			case 'f': options.nFuzzyDistance = atoi( optarg); break;
+			case 'D':
+				if( ! dictionary.open( optarg)) {
+					fprintf( stderr, "%s\n", dictionary.getError());
+					return( EXIT_FAILURE);
+				}
+				options.pDictionary = &dictionary;
+				break;
+			default: usage( argv[0]); return( EXIT_FAILURE);
+		}
+	}
+	if( ((optind + 1) != argc) || (0 > options.nColumn) || (0 > options.nThreads) || (0 > options.nFuzzyDistance) || (MAX_FUZZY_DISTANCE < options.nFuzzyDistance)) {
+		usage( argv[0]);
+		return( EXIT_FAILURE);
+	}
+	options.pInputFile = argv[optind];
+	if( 0 == options.nThreads) options.nThreads = (int) std::thread::hardware_concurrency();
+	if( 0 == options.nThreads) options.nThreads = 1;
+
+	// Map the input
+	int fdInput = open( options.pInputFile, O_RDONLY);
+	if( 0 > fdInput) {
+		fprintf( stderr, "Unable to open %s: %s\n", options.pInputFile, strerror( errno));
+		return( EXIT_FAILURE);
+	}
+	struct stat statInput;
+	if( 0 != fstat( fdInput, &statInput)) {
+		fprintf( stderr, "Unable to stat %s: %s\n", options.pInputFile, strerror( errno));
+		close( fdInput);
+		return( EXIT_FAILURE);
+	}
+	const size_t inputSize = (size_t) statInput.st_size;
+	const char *pInput = (const char *) 0x0;
+	if( 0 < inputSize) {
+		void *pMap = mmap( (void *) 0x0, inputSize, PROT_READ, MAP_PRIVATE, fdInput, 0);
+		if( MAP_FAILED == pMap) {
+			fprintf( stderr, "Unable to map %s: %s\n", options.pInputFile, strerror( errno));
+			close( fdInput);
+			return( EXIT_FAILURE);
+		}
+		madvise( pMap, inputSize, MADV_SEQUENTIAL);
+		pInput = (const char *) pMap;
+	}
+
+	// Skip the header
+	const char *pStart = pInput;
+	const char *pEnd = pInput + inputSize;
+	if( options.bSkipHeader && (0 < inputSize)) {
+		const char *pNewLine = (const char *) memchr( pStart, '\n', inputSize);
+		pStart = ((const char *) 0x0 == pNewLine) ? pEnd : (pNewLine + 1);
+	}
+
+	// Parse every line
+	bool bFailed = false;
+	if( 0 < options.cacheBytes) options.pCache = new libAddr::deliveryLineCache( options.cacheBytes);
+	if( 1 < options.nThreads) {
+		parsePipeline pipeline( options, pStart, pEnd, STDOUT_FILENO);
+		bFailed = ! pipeline.run( );
+	}
+	else {
+		S_OUTPUT_BUFFER output = { STDOUT_FILENO, 0, OUTPUT_BUFFER_SIZE, false, (char *) malloc( OUTPUT_BUFFER_SIZE) };
+		if( (char *) 0x0 == output.pBuffer) {
+			fprintf( stderr, "Unable to allocate the output buffer\n");
+			return( EXIT_FAILURE);
+		}
+		libAddr::deliveryLineParser parser;
+		parser.setEngine( options.engine);
+		parser.setDictionary( options.pDictionary);
+		parser.setFuzzyDistance( options.nFuzzyDistance);
+		parseRange( pStart, pEnd, options, parser, output);
+		flushOutput( output);
+		bFailed = output.bFailed;
+		free( output.pBuffer);
+	}
+
+	// Report and drop the cache
+	if( (libAddr::deliveryLineCache *) 0x0 != options.pCache) {
+		libAddr::S_CACHE_STATISTICS statistics;
+		options.pCache->getStatistics( statistics);
+		fprintf( stderr, "Cache: %llu hits, %llu misses, %llu evictions, %llu entries in %llu bytes\n",
+			(unsigned long long) statistics.hits, (unsigned long long) statistics.misses, (unsigned long long) statistics.evictions,
+			(unsigned long long) statistics.entries, (unsigned long long) statistics.bytesUsed);
+		delete options.pCache;
+	}
+
+	// Clean up
+	if( 0 < inputSize) munmap( (void *) pInput, inputSize);
+	close( fdInput);
+	if( bFailed) fprintf( stderr, "Unable to write the output: %s\n", strerror( errno));
+	return( bFailed ? EXIT_FAILURE : EXIT_SUCCESS);
+
+}